@@ -0,0 +1,58 @@
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "alloc_count.hpp"
+
+static std::atomic<uint64_t> allocations{0};
+// trivially initialised, so it is safe to touch from `operator new` on any thread
+static thread_local uint64_t thread_allocations = 0;
+
+uint64_t allocation_count() { return allocations.load(std::memory_order_relaxed); }
+uint64_t thread_allocation_count() { return thread_allocations; }
+
+static void *counted_alloc(std::size_t size) {
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	++thread_allocations;
+	if (size == 0) {
+		size = 1;
+	}
+	void *p = std::malloc(size);
+	if (p == nullptr) {
+		throw std::bad_alloc();
+	}
+	return p;
+}
+
+static void *counted_alloc(std::size_t size, std::align_val_t align) {
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	++thread_allocations;
+	auto alignment = static_cast<std::size_t>(align);
+	// aligned_alloc wants the size to be a multiple of the alignment
+	size = ((size + alignment - 1) / alignment) * alignment;
+	void *p = std::aligned_alloc(alignment, size == 0 ? alignment : size);
+	if (p == nullptr) {
+		throw std::bad_alloc();
+	}
+	return p;
+}
+
+void *operator new(std::size_t size) { return counted_alloc(size); }
+void *operator new[](std::size_t size) { return counted_alloc(size); }
+void *operator new(std::size_t size, std::align_val_t align) {
+	return counted_alloc(size, align);
+}
+void *operator new[](std::size_t size, std::align_val_t align) {
+	return counted_alloc(size, align);
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+void operator delete(void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t, std::align_val_t) noexcept {
+	std::free(p);
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <cstdint>
+
+// Number of heap allocations made through the global `operator new` since start
+// up. Only counts when alloc_count.cpp is linked in, it replaces the global
+// allocation functions.
+uint64_t allocation_count();
+// The same, counting only the allocations of the calling thread
+uint64_t thread_allocation_count();
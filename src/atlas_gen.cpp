@@ -0,0 +1,136 @@
+// Build step that packs the block sprites into a header, so the game starts with
+// the atlas already in its binary and reads no files.
+//
+// usage: tetris_atlas_gen <block.png> <block_atlas.hpp>
+//
+// Only the full size sprite is drawn by hand. The medium and tiny ones are made
+// from it by averaging squares of pixels, weighted by alpha so transparent pixels
+// do not darken the edges. The three are laid out side by side in one gray and
+// alpha image, written out as a byte array with the place of each sprite.
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "raylib.h"
+
+#include "block.hpp"
+
+// Sizes of the sprites in `BlockSprite` order
+const std::array<int, 3> SPRITE_SIZES = {BLOCK_SIZE, MEDIUMBLOCK_SIZE, TINYBLOCK_SIZE};
+
+// Gray and alpha, two bytes a pixel, rows top to bottom
+struct Pixels {
+	int width = 0;
+	int height = 0;
+	std::vector<uint8_t> data;
+
+	size_t index(int x, int y) const {
+		return 2 * ((static_cast<size_t>(y) * static_cast<size_t>(width)) +
+					static_cast<size_t>(x));
+	}
+	uint8_t *at(int x, int y) { return &data[index(x, y)]; }
+	const uint8_t *at(int x, int y) const { return &data[index(x, y)]; }
+};
+
+// `base` shrunk to a `size` square, `base` must be a multiple of it
+static Pixels shrink(const Pixels &base, int size) {
+	Pixels out{.width = size, .height = size, .data = {}};
+	out.data.resize(2 * static_cast<size_t>(size * size));
+	int f = base.width / size;
+	for (int y = 0; y < size; ++y) {
+		for (int x = 0; x < size; ++x) {
+			unsigned gray = 0;
+			unsigned alpha = 0;
+			for (int dy = 0; dy < f; ++dy) {
+				for (int dx = 0; dx < f; ++dx) {
+					const uint8_t *p = base.at((x * f) + dx, (y * f) + dy);
+					gray += p[0] * p[1];
+					alpha += p[1];
+				}
+			}
+			uint8_t *q = out.at(x, y);
+			unsigned n = static_cast<unsigned>(f * f);
+			q[0] = static_cast<uint8_t>(alpha > 0 ? (gray + (alpha / 2)) / alpha : 0);
+			q[1] = static_cast<uint8_t>((alpha + (n / 2)) / n);
+		}
+	}
+	return out;
+}
+
+int main(int argc, char **argv) {
+	if (argc != 3) {
+		std::fprintf(stderr, "usage: %s <block.png> <block_atlas.hpp>\n", argv[0]);
+		return 1;
+	}
+
+	Image img = LoadImage(argv[1]);
+	if (img.data == nullptr) {
+		std::fprintf(stderr, "cannot load %s\n", argv[1]);
+		return 1;
+	}
+	if (img.width != BLOCK_SIZE || img.height != BLOCK_SIZE) {
+		std::fprintf(
+			stderr, "%s is %dx%d, expected %dx%d\n", argv[1], img.width, img.height,
+			BLOCK_SIZE, BLOCK_SIZE
+		);
+		return 1;
+	}
+	ImageFormat(&img, PIXELFORMAT_UNCOMPRESSED_GRAY_ALPHA);
+	Pixels base{.width = img.width, .height = img.height, .data = {}};
+	const auto *bytes = static_cast<const uint8_t *>(img.data);
+	base.data.assign(bytes, bytes + (2 * img.width * img.height));
+	UnloadImage(img);
+
+	Pixels atlas{};
+	for (int size : SPRITE_SIZES) {
+		atlas.width += size;
+	}
+	atlas.height = BLOCK_SIZE;
+	atlas.data.resize(2 * static_cast<size_t>(atlas.width * atlas.height));
+	std::array<int, 3> sprite_x{};
+	int x = 0;
+	for (size_t i = 0; i < SPRITE_SIZES.size(); ++i) {
+		Pixels sprite = i == 0 ? base : shrink(base, SPRITE_SIZES[i]);
+		sprite_x[i] = x;
+		for (int sy = 0; sy < sprite.height; ++sy) {
+			for (int sx = 0; sx < sprite.width; ++sx) {
+				const uint8_t *p = sprite.at(sx, sy);
+				uint8_t *q = atlas.at(x + sx, sy);
+				q[0] = p[0];
+				q[1] = p[1];
+			}
+		}
+		x += sprite.width;
+	}
+
+	FILE *f = std::fopen(argv[2], "w");
+	if (f == nullptr) {
+		std::perror(argv[2]);
+		return 1;
+	}
+	std::fprintf(
+		f,
+		"// Generated by tetris_atlas_gen from %s, do not edit.\n"
+		"#pragma once\n\n"
+		"// Gray and alpha, two bytes a pixel\n"
+		"const int BLOCK_ATLAS_WIDTH = %d;\n"
+		"const int BLOCK_ATLAS_HEIGHT = %d;\n"
+		"// Left edge and size of each `BlockSprite`, all are square and at the top\n"
+		"const int BLOCK_ATLAS_SPRITE_X[3] = {%d, %d, %d};\n"
+		"const int BLOCK_ATLAS_SPRITE_SIZE[3] = {%d, %d, %d};\n"
+		"const unsigned char BLOCK_ATLAS_PIXELS[] = {",
+		argv[1], atlas.width, atlas.height, sprite_x[0], sprite_x[1], sprite_x[2],
+		SPRITE_SIZES[0], SPRITE_SIZES[1], SPRITE_SIZES[2]
+	);
+	for (size_t i = 0; i < atlas.data.size(); ++i) {
+		std::fprintf(f, "%s%u,", i % 16 == 0 ? "\n\t" : " ", atlas.data[i]);
+	}
+	std::fprintf(f, "\n};\n");
+	if (std::fclose(f) != 0) {
+		std::perror(argv[2]);
+		return 1;
+	}
+	return 0;
+}
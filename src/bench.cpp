@@ -0,0 +1,336 @@
+// Micro-benchmarks for the hot paths of tetris_core.
+//
+// usage: tetris_bench [results.json]
+//
+// Every case is run on an empty, a half full and a nearly full board, and the
+// board operations once more on the training and big board variants and on a
+// 10000 row tower board. The table on stdout and the JSON file report nanoseconds
+// and heap allocations per operation, the JSON is meant to be diffed between
+// builds.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "alloc_count.hpp"
+#include "board.hpp"
+#include "bot.hpp"
+#include "collision.hpp"
+#include "game.hpp"
+#include "position.hpp"
+#include "randomizer.hpp"
+#include "rowscan.hpp"
+#include "tet.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+// Keeps the compiler from optimising away a result.
+template <class T> static void keep(T const &value) {
+	asm volatile("" : : "r,m"(value) : "memory");
+}
+
+struct BenchResult {
+	std::string name;
+	std::string fill;
+	double ns_per_op;
+	double allocs_per_op;
+	uint64_t iterations;
+};
+
+struct Fill {
+	const char *name;
+	int rows; // rows filled from the bottom, each with one hole
+};
+
+const std::array<Fill, 3> FILLS = {{
+	{.name = "empty", .rows = 0},
+	{.name = "half", .rows = GRID_HEIGHT / 2},
+	{.name = "nearly_full", .rows = GRID_HEIGHT - 3},
+}};
+
+template <class B> static B make_board(int rows, uint32_t seed) {
+	std::mt19937 rng(seed);
+	B board{};
+	for (int y = B::HEIGHT - rows; y < B::HEIGHT; ++y) {
+		int hole = static_cast<int>(rng() % B::WIDTH);
+		for (int x = 0; x < B::WIDTH; ++x) {
+			if (x == hole) {
+				continue;
+			}
+			Block b{.pos = {.x = x, .y = y}, .color = COLOR_J};
+			board.place({b, b, b, b});
+		}
+	}
+	return board;
+}
+
+// Fills the holes of the bottom `count` rows, so they clear on the next lock.
+template <class B> static std::array<Block, 4> fill_holes(B &board, int count) {
+	std::array<Block, 4> placed{};
+	for (int i = 0; i < 4; ++i) {
+		int y = B::HEIGHT - 1 - std::min(i, count - 1);
+		for (int x = 0; x < B::WIDTH; ++x) {
+			if (!board.occupied(x, y)) {
+				placed[static_cast<size_t>(i)] = {
+					.pos = {.x = x, .y = y}, .color = COLOR_I
+				};
+			}
+		}
+	}
+	board.place(placed);
+	return placed;
+}
+
+// The active piece where the game loop would see it: spawned and moved down to
+// just above the stack.
+static Tetramino resting_above(Tetramino tet, const Board &board) {
+	auto ghost = drop_ghost(tet, board);
+	int lift = std::min(2, ghost.get_y_offset() - tet.get_y_offset());
+	tet.move(0, ghost.get_y_offset() - tet.get_y_offset() - lift);
+	return tet;
+}
+
+// A piece placed so that rotating clockwise only succeeds on a later kick test.
+static std::optional<Tetramino> find_kick_case(PieceType type, const Board &board) {
+	std::optional<Tetramino> best;
+	int best_kick = 0;
+	for (int y = -3; y < GRID_HEIGHT; ++y) {
+		for (int x = -3; x < GRID_WIDTH; ++x) {
+			if (piece_obstructed(board, type, 0, x, y)) {
+				continue;
+			}
+			Tetramino tet(type);
+			tet.move(x - tet.get_x_offset(), y - tet.get_y_offset());
+			const auto &kicks = PIECES[type].cw_kicks[0];
+			for (int k = 0; k < 5; ++k) {
+				auto test = kicks[static_cast<size_t>(k)];
+				if (!piece_obstructed(board, type, 1, x + test.x, y + test.y)) {
+					if (k > best_kick) {
+						best_kick = k;
+						best = tet;
+					}
+					break;
+				}
+			}
+		}
+	}
+	return best;
+}
+
+template <class F>
+static BenchResult run(const std::string &name, const char *fill, F &&op) {
+	// grow the batch until it takes long enough to time reliably
+	uint64_t iterations = 1;
+	for (;;) {
+		auto start = Clock::now();
+		for (uint64_t i = 0; i < iterations; ++i) {
+			op();
+		}
+		if (Clock::now() - start > std::chrono::milliseconds(20)) {
+			break;
+		}
+		iterations *= 2;
+	}
+
+	// best of a few batches
+	double best = 1e300;
+	uint64_t allocs = 0;
+	for (int round = 0; round < 5; ++round) {
+		uint64_t alloc_start = allocation_count();
+		auto start = Clock::now();
+		for (uint64_t i = 0; i < iterations; ++i) {
+			op();
+		}
+		auto end = Clock::now();
+		allocs = allocation_count() - alloc_start;
+		double ns = std::chrono::duration<double, std::nano>(end - start).count();
+		best = std::min(best, ns / static_cast<double>(iterations));
+	}
+
+	BenchResult res{
+		.name = name,
+		.fill = fill,
+		.ns_per_op = best,
+		.allocs_per_op = static_cast<double>(allocs) / static_cast<double>(iterations),
+		.iterations = iterations,
+	};
+	std::printf(
+		"%-28s %-12s %12.2f ns/op %8.3f allocs/op\n",
+		res.name.c_str(),
+		res.fill.c_str(),
+		res.ns_per_op,
+		res.allocs_per_op
+	);
+	return res;
+}
+
+// The board variants other than the one the game is played on, half full. Named
+// after their size in the fill column.
+template <class B>
+static void bench_variant(const char *size, std::vector<BenchResult> &results) {
+	const B board = make_board<B>(B::HEIGHT / 2, 42);
+	Tetramino tet{PIECE_T, 0, 0, 0};
+	tet.move(0, board.drop_distance(tet.blocks()) - 2);
+
+	results.push_back(run("check_collision", size, [&] {
+		keep(check_collision(tet.blocks(), board));
+	}));
+	results.push_back(run("check_obstruction", size, [&] {
+		keep(check_obstruction(tet.blocks(), board));
+	}));
+	for (int lines : {1, 4}) {
+		B full = board;
+		auto placed = fill_holes(full, lines);
+		results.push_back(run("clear_blocks_" + std::to_string(lines), size, [&] {
+			B b = full;
+			keep(clear_blocks(b, placed));
+			keep(b);
+		}));
+	}
+	results.push_back(run("rotate_cw", size, [&] {
+		auto t = tet;
+		keep(t.rotate_cw(board));
+	}));
+}
+
+// Tower mode, a 10000 row board stacked half way up. Garbage comes in full so the
+// following clear takes it out again and every iteration starts from the same board.
+static void bench_tower(std::vector<BenchResult> &results) {
+	auto board = std::make_unique<TowerBoard>(
+		make_board<TowerBoard>(TowerBoard::HEIGHT / 2, 42)
+	);
+	std::printf("row scan kernel: %s\n", row_scan_kernel());
+
+	results.push_back(run("clear_full_rows", "tower", [&] {
+		keep(board->clear_full_rows());
+	}));
+	for (int lines : {1, 4}) {
+		std::array<Row, 4> garbage{};
+		garbage.fill(TowerBoard::FULL_ROW);
+		results.push_back(run("garbage_and_clear_" + std::to_string(lines), "tower", [&] {
+			keep(board->insert_garbage(garbage.data(), lines, COLOR_J));
+			keep(board->clear_full_rows());
+		}));
+	}
+}
+
+static void write_json(const char *path, const std::vector<BenchResult> &results) {
+	FILE *f = std::fopen(path, "w");
+	if (f == nullptr) {
+		std::perror(path);
+		return;
+	}
+	std::fprintf(f, "{\n  \"results\": [\n");
+	for (size_t i = 0; i < results.size(); ++i) {
+		const auto &r = results[i];
+		std::fprintf(
+			f,
+			"    {\"name\": \"%s\", \"fill\": \"%s\", \"ns_per_op\": %.3f, "
+			"\"allocs_per_op\": %.4f, \"iterations\": %llu}%s\n",
+			r.name.c_str(),
+			r.fill.c_str(),
+			r.ns_per_op,
+			r.allocs_per_op,
+			static_cast<unsigned long long>(r.iterations),
+			i + 1 < results.size() ? "," : ""
+		);
+	}
+	std::fprintf(f, "  ]\n}\n");
+	std::fclose(f);
+}
+
+int main(int argc, char **argv) {
+	const char *out_path = argc > 1 ? argv[1] : "bench_results.json";
+	std::vector<BenchResult> results;
+
+	for (const auto &fill : FILLS) {
+		const Board board = make_board<Board>(fill.rows, 42);
+		const Tetramino tet = resting_above(create_t_tet(), board);
+
+		results.push_back(run("check_collision", fill.name, [&] {
+			keep(check_collision(tet.blocks(), board));
+		}));
+		results.push_back(run("check_obstruction", fill.name, [&] {
+			keep(check_obstruction(tet.blocks(), board));
+		}));
+		results.push_back(run("check_all_collisions", fill.name, [&] {
+			keep(check_all_collisions(tet, board));
+		}));
+
+		for (int lines : {1, 4}) {
+			if (fill.rows < lines) {
+				continue;
+			}
+			Board full = board;
+			auto placed = fill_holes(full, lines);
+			results.push_back(run(
+				"clear_blocks_" + std::to_string(lines), fill.name, [&] {
+					Board b = full;
+					keep(clear_blocks(b, placed));
+					keep(b);
+				}
+			));
+		}
+
+		results.push_back(run("rotate_cw", fill.name, [&] {
+			auto t = tet;
+			keep(t.rotate_cw(board));
+		}));
+		results.push_back(run("rotate_ccw", fill.name, [&] {
+			auto t = tet;
+			keep(t.rotate_ccw(board));
+		}));
+		for (PieceType type : {PIECE_I, PIECE_T}) {
+			auto kick = find_kick_case(type, board);
+			if (!kick.has_value()) {
+				continue;
+			}
+			std::string name = type == PIECE_I ? "rotate_cw_kick_i" : "rotate_cw_kick_t";
+			results.push_back(run(name, fill.name, [&] {
+				auto t = *kick;
+				keep(t.rotate_cw(board));
+			}));
+		}
+
+		const Tetramino spawned = create_i_tet();
+		results.push_back(run("ghost_drop", fill.name, [&] {
+			keep(drop_ghost(spawned, board));
+		}));
+
+		// one move of the default bot, the first call warms its scratch space up
+		GameState st = Game{42}.state();
+		st.board = board;
+		BeamBot bot;
+		BotMove move{};
+		bot.think(st, move);
+		results.push_back(run("beam_think", fill.name, [&] {
+			keep(bot.think(st, move));
+		}));
+	}
+
+	bench_variant<TrainingBoard>("4x20", results);
+	bench_variant<BigBoard>("64x64", results);
+	bench_tower(results);
+
+	Randomizer randomizer{42};
+	results.push_back(run("randomizer_draw", "-", [&] { keep(randomizer.draw()); }));
+
+	// the position hash from scratch, `Game` only pays for the features that change
+	const Game game{42};
+	results.push_back(run("position_hash", "-", [&] {
+		keep(position_hash(game.state()));
+	}));
+	results.push_back(run("pack_position", "-", [&] {
+		keep(pack_position(game.state()));
+	}));
+
+	write_json(out_path, results);
+	std::printf("wrote %s\n", out_path);
+	return 0;
+}
@@ -1,9 +1,6 @@
 #pragma once
 
-#include <tuple>
-#include <vector>
-
-#include "raylib.h"
+#include <cstdint>
 
 const int BLOCK_SIZE = 32.0;
 const int MEDIUMBLOCK_SIZE = 16.0;
@@ -16,39 +13,20 @@ struct Coordinate {
 	int y; // Y coordinate in grid
 };
 
+// Palette index of a block. The board stores one of these per cell, `COLOR_NONE`
+// marks an empty cell.
+enum BlockColor : uint8_t {
+	COLOR_NONE = 0,
+	COLOR_I,
+	COLOR_T,
+	COLOR_J,
+	COLOR_L,
+	COLOR_O,
+	COLOR_S,
+	COLOR_Z,
+};
+
 struct Block {
 	Coordinate pos;
-	Color color;
-
-	void draw_pro(
-		int x_margin, int y_margin, int x_offset, int y_offset, Texture2D texture,
-		float opacity
-	);
-
-	void draw(
-		int x_margin = 0, int y_margin = 0, int x_offset = 0, int y_offset = 0,
-		float opacity = 1
-	);
-	void draw_medium(
-		int x_margin = 0, int y_margin = 0, int x_offset = 0, int y_offset = 0,
-		float opacity = 1
-	);
-	void draw_tiny(
-		int x_margin = 0, int y_margin = 0, int x_offset = 0, int y_offset = 0,
-		float opacity = 1
-	);
+	BlockColor color;
 };
-
-// Returns a `tuple<int, vector<Block>>`, where the int is the number of lines
-// cleared, and the vector is the transformed vector of blocks
-std::tuple<int, std::vector<Block>> clear_blocks(std::vector<Block> blocks);
-
-void load_block_texture();
-void unload_block_texture();
-
-void draw_blocks(
-	std::vector<Block> blocks, int x_margin, int y_margin, float opacity = 1
-);
-void draw_blocks(
-	std::array<Block, 4> blocks, int x_margin, int y_margin, float opacity = 1
-);
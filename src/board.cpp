@@ -0,0 +1,211 @@
+#include <algorithm>
+#include <bit>
+#include <limits>
+
+#include "board.hpp"
+#include "rowscan.hpp"
+
+template <int W, int H> BasicBoard<W, H>::BasicBoard() { surface.fill(H); }
+
+template <int W, int H> void BasicBoard<W, H>::update_surface() {
+	// removing rows never fills a column, only the ones with blocks need a look
+	Row remaining{};
+	for (int x = 0; x < W; ++x) {
+		if (surface[static_cast<size_t>(x)] < H) {
+			remaining = static_cast<Row>(remaining | row_cells<Row>(1U, x));
+		}
+	}
+	surface.fill(H);
+	size_t y = first_nonempty_row(rows.data(), rows.size());
+	for (; y < rows.size() && !row_empty(remaining); ++y) {
+		Row found = static_cast<Row>(rows[y] & remaining);
+		for (size_t x = 0; !row_empty(found); ++x, found >>= 1) {
+			if (row_test(found, 0)) {
+				surface[x] = static_cast<int>(y);
+			}
+		}
+		remaining = static_cast<Row>(remaining & ~rows[y]);
+	}
+}
+
+template <int W, int H>
+void BasicBoard<W, H>::move_down(size_t begin, size_t end, size_t to) {
+	std::copy_backward(rows.begin() + begin, rows.begin() + end, rows.begin() + to);
+	std::copy_backward(colors.begin() + begin, colors.begin() + end, colors.begin() + to);
+}
+
+template <int W, int H>
+int BasicBoard<W, H>::drop_distance(const std::array<Block, 4> &blocks) const {
+	int distance = std::numeric_limits<int>::max();
+	for (const auto &b : blocks) {
+		// a block outside the columns has no surface, leave it to the cell by
+		// cell search
+		if (b.pos.x < 0 || b.pos.x >= W) {
+			distance = -1;
+			break;
+		}
+		int top = surface[static_cast<size_t>(b.pos.x)];
+		if (b.pos.y >= top) {
+			distance = -1;
+			break;
+		}
+		distance = std::min(distance, top - 1 - b.pos.y);
+	}
+	if (distance >= 0) {
+		return distance;
+	}
+
+	// under an overhang, the surface says nothing about what is below the piece
+	for (distance = 0;; ++distance) {
+		for (const auto &b : blocks) {
+			int below = b.pos.y + distance + 1;
+			if (below >= H || occupied(b.pos.x, below)) {
+				return distance;
+			}
+		}
+	}
+}
+
+template <int W, int H>
+void BasicBoard<W, H>::place(const std::array<Block, 4> &blocks) {
+	for (const auto &b : blocks) {
+		if (b.pos.x < 0 || b.pos.x >= W || b.pos.y < 0 || b.pos.y >= H) {
+			continue;
+		}
+		auto y = static_cast<size_t>(b.pos.y);
+		auto x = static_cast<size_t>(b.pos.x);
+		rows[y] = static_cast<Row>(rows[y] | row_cells<Row>(1U, b.pos.x));
+		colors[y][x] = b.color;
+		surface[x] = std::min(surface[x], b.pos.y);
+	}
+}
+
+template <int W, int H> void BasicBoard<W, H>::remove_rows(const LineClear &lines) {
+	// Walking up from the lowest cleared row, each run of rows between two cleared
+	// rows moves down by the number of cleared rows below it. Nothing above the
+	// topmost block needs moving, which matters on tall boards.
+	size_t top = first_nonempty_row(rows.data(), rows.size());
+	for (int i = lines.count - 1; i >= 0; --i) {
+		auto shift = static_cast<size_t>(lines.count - i);
+		auto end = static_cast<size_t>(lines.rows[static_cast<size_t>(i)]);
+		size_t begin = top;
+		if (i > 0) {
+			begin = static_cast<size_t>(lines.rows[static_cast<size_t>(i - 1)]) + 1;
+		}
+		move_down(begin, end, end + shift);
+	}
+
+	auto cleared = static_cast<size_t>(lines.count);
+	std::fill(rows.begin() + top, rows.begin() + top + cleared, Row{});
+	std::fill(
+		colors.begin() + top,
+		colors.begin() + top + cleared,
+		std::array<BlockColor, W>{}
+	);
+	update_surface();
+}
+
+template <int W, int H> int BasicBoard<W, H>::clear_full_rows() {
+	std::array<uint64_t, (H + 63) / 64> full{};
+	find_rows_equal(rows.data(), rows.size(), FULL_ROW, full.data());
+
+	// same walk as `remove_rows`, with the full rows read off the bitmap bottom up
+	size_t top = first_nonempty_row(rows.data(), rows.size());
+	size_t end = H; // one past the run of surviving rows being looked at
+	size_t to = H;  // where that run moves to
+	int removed = 0;
+	for (size_t w = full.size(); w-- > 0;) {
+		for (uint64_t bits = full[w]; bits != 0;) {
+			auto bit = static_cast<size_t>(63 - std::countl_zero(bits));
+			bits &= ~(uint64_t{1} << bit);
+			size_t y = w * 64 + bit;
+			move_down(y + 1, end, to);
+			to -= end - (y + 1);
+			end = y;
+			++removed;
+		}
+	}
+	if (removed == 0) {
+		return 0;
+	}
+	move_down(top, end, to);
+
+	auto cleared = static_cast<size_t>(removed);
+	std::fill(rows.begin() + top, rows.begin() + top + cleared, Row{});
+	std::fill(
+		colors.begin() + top,
+		colors.begin() + top + cleared,
+		std::array<BlockColor, W>{}
+	);
+	update_surface();
+	return removed;
+}
+
+template <int W, int H>
+bool BasicBoard<W, H>::insert_garbage(const Row *garbage, int count, BlockColor color) {
+	auto k = static_cast<size_t>(std::clamp(count, 0, H));
+	size_t top = first_nonempty_row(rows.data(), rows.size());
+	bool fits = top >= k;
+	// the empty rows above the stack stay where they are
+	size_t begin = std::max(top, k);
+	std::copy(rows.begin() + begin, rows.end(), rows.begin() + (begin - k));
+	std::copy(colors.begin() + begin, colors.end(), colors.begin() + (begin - k));
+
+	for (size_t x = 0; x < surface.size(); ++x) {
+		if (surface[x] < H) {
+			surface[x] = std::max(0, surface[x] - static_cast<int>(k));
+		}
+	}
+	for (size_t i = 0; i < k; ++i) {
+		size_t y = H - k + i;
+		rows[y] = garbage[i];
+		for (int x = 0; x < W; ++x) {
+			auto col = static_cast<size_t>(x);
+			bool set = row_test(garbage[i], x);
+			colors[y][col] = set ? color : COLOR_NONE;
+			if (set && surface[col] == H) {
+				surface[col] = static_cast<int>(y);
+			}
+		}
+	}
+	if (!fits) {
+		// columns may have lost their top blocks, look at every one of them again
+		surface.fill(0);
+		update_surface();
+	}
+	return fits;
+}
+
+template <int W, int H>
+LineClear clear_blocks(BasicBoard<W, H> &board, const std::array<Block, 4> &placed) {
+	LineClear lines{};
+	for (const auto &b : placed) {
+		int y = b.pos.y;
+		if (y < 0 || y >= H || !board.full(y)) {
+			continue;
+		}
+		// keep `rows` sorted and free of duplicates
+		auto end = lines.rows.begin() + lines.count;
+		auto it = std::lower_bound(lines.rows.begin(), end, y);
+		if (it != end && *it == y) {
+			continue;
+		}
+		std::copy_backward(it, end, end + 1);
+		*it = y;
+		++lines.count;
+	}
+
+	if (lines.count > 0) {
+		board.remove_rows(lines);
+	}
+	return lines;
+}
+
+template class BasicBoard<GRID_WIDTH, GRID_HEIGHT>;
+template class BasicBoard<4, 20>;
+template class BasicBoard<64, 64>;
+template class BasicBoard<GRID_WIDTH, 10000>;
+template LineClear clear_blocks(Board &, const std::array<Block, 4> &);
+template LineClear clear_blocks(TrainingBoard &, const std::array<Block, 4> &);
+template LineClear clear_blocks(BigBoard &, const std::array<Block, 4> &);
+template LineClear clear_blocks(TowerBoard &, const std::array<Block, 4> &);
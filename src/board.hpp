@@ -0,0 +1,139 @@
+#pragma once
+
+#include <array>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+#include "block.hpp"
+
+// One bit per cell, bit `x` is set when column `x` of the row is occupied. The
+// smallest unsigned integer a row of `W` cells fits in, a bitset of several words
+// past 64 cells.
+template <int W>
+using RowBits = std::conditional_t<
+	(W <= 16), uint16_t,
+	std::conditional_t<
+		(W <= 32), uint32_t, std::conditional_t<(W <= 64), uint64_t, std::bitset<W>>>>;
+
+// Row bit operations that read the same for integer and bitset rows. They compile
+// down to plain integer instructions for the integer ones.
+template <class R> bool row_empty(const R &row) {
+	if constexpr (std::is_integral_v<R>) {
+		return row == 0;
+	} else {
+		return row.none();
+	}
+}
+template <class R> bool row_test(const R &row, int x) {
+	if constexpr (std::is_integral_v<R>) {
+		return (row >> x) & 1U;
+	} else {
+		return row.test(static_cast<size_t>(x));
+	}
+}
+// `mask` moved over by `x` columns, to the left for a negative `x`
+template <class R> R row_cells(unsigned mask, int x) {
+	R cells = static_cast<R>(mask);
+	if (x >= 0) {
+		return static_cast<R>(cells << static_cast<size_t>(x));
+	}
+	return static_cast<R>(cells >> static_cast<size_t>(-x));
+}
+template <class R, int W> constexpr R full_row() {
+	if constexpr (std::is_integral_v<R>) {
+		return static_cast<R>(
+			static_cast<R>(~R{0}) >> (std::numeric_limits<R>::digits - W)
+		);
+	} else {
+		return R{}.set();
+	}
+}
+
+// Rows removed by a line clear, top to bottom. Only the first `count` are set.
+struct LineClear {
+	int count = 0;
+	std::array<int, 4> rows{};
+};
+
+// The settled blocks of a game on a `W` by `H` grid. Occupancy is kept as one
+// bitmask per row, so collision and full row tests are a couple of bit operations
+// per cell no matter how many blocks are on the board. Colors are kept separately,
+// as a palette index per cell, and are only needed for drawing.
+//
+// The size is a template parameter so every variant gets its own fully specialised
+// code, the members are instantiated in board.cpp for the aliases below.
+template <int W, int H> class BasicBoard {
+	static_assert(W >= 4 && H >= 4, "every piece must fit on the board");
+
+  public:
+	typedef RowBits<W> Row;
+	static constexpr int WIDTH = W;
+	static constexpr int HEIGHT = H;
+	static inline const Row FULL_ROW = full_row<Row, W>();
+
+  private:
+	std::array<Row, H> rows{};
+	std::array<std::array<BlockColor, W>, H> colors{};
+	// Row of the topmost block in each column, `H` for an empty column
+	std::array<int, W> surface{};
+
+	// Finds the topmost block of each column again after rows were removed
+	void update_surface();
+	// Moves rows [`begin`, `end`) down so the last lands just above row `to`
+	void move_down(size_t begin, size_t end, size_t to);
+
+  public:
+	BasicBoard();
+
+	// Cells outside the grid are never occupied, walls are handled by the caller.
+	bool occupied(int x, int y) const {
+		if (x < 0 || x >= W || y < 0 || y >= H) {
+			return false;
+		}
+		return row_test(rows[static_cast<size_t>(y)], x);
+	}
+	BlockColor color(int x, int y) const {
+		return colors[static_cast<size_t>(y)][static_cast<size_t>(x)];
+	}
+	const Row &row(int y) const { return rows[static_cast<size_t>(y)]; }
+	bool full(int y) const { return rows[static_cast<size_t>(y)] == FULL_ROW; }
+	int surface_y(int x) const { return surface[static_cast<size_t>(x)]; }
+
+	// How many rows `blocks` can fall before landing. When every block is above the
+	// surface of its column this is read straight off the surface, only a piece
+	// tucked under an overhang is stepped down a row at a time.
+	int drop_distance(const std::array<Block, 4> &blocks) const;
+
+	// Settles `blocks` on the board. Blocks outside the grid are dropped.
+	void place(const std::array<Block, 4> &blocks);
+	// Removes the rows of `lines` and moves the rows above them down, copying each
+	// surviving row at most once.
+	void remove_rows(const LineClear &lines);
+
+	// Removes every full row of the board and moves the rest down, returns how many
+	// were removed. For when there is no placed piece to say which rows to test,
+	// the rows are compared many at a time (see rowscan.hpp).
+	int clear_full_rows();
+	// Pushes the stack up by `count` rows and fills the rows freed at the bottom
+	// with `garbage`, given top to bottom, in `color`. Returns false when blocks
+	// were pushed out the top, they are lost.
+	bool insert_garbage(const Row *garbage, int count, BlockColor color);
+};
+
+// The board the game is played on
+typedef BasicBoard<GRID_WIDTH, GRID_HEIGHT> Board;
+typedef Board::Row Row;
+// Four wide, for combo training
+typedef BasicBoard<4, 20> TrainingBoard;
+typedef BasicBoard<64, 64> BigBoard;
+// Endless tower mode, garbage comes in from below
+typedef BasicBoard<GRID_WIDTH, 10000> TowerBoard;
+
+// Clears the full rows of `board` in place. Only the rows of the `placed` piece can
+// have filled up since the last clear, so no other row is tested. The row masks
+// double as the fill counts, a row is full when its mask is `FULL_ROW`.
+template <int W, int H>
+LineClear clear_blocks(BasicBoard<W, H> &board, const std::array<Block, 4> &placed);
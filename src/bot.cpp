@@ -0,0 +1,201 @@
+#include <algorithm>
+
+#include "bot.hpp"
+#include "policy.hpp"
+#include "position.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+// Placements of a piece room is made for up front, a piece on a standard board
+// rarely has more. Past that the scratch space grows on the first move that needs
+// it.
+const size_t RESERVED_PLACEMENTS = 48;
+
+BeamBot::BeamBot(const BotConfig &bot_config) : config{bot_config} {
+	config.beam_width = std::max<size_t>(config.beam_width, 1);
+	size_t table = 4;
+	while (table < 4 * config.beam_width) {
+		table *= 2;
+	}
+	seen.resize(table);
+
+	// each node is expanded at most twice, with and without holding
+	size_t most = 2 * config.beam_width * RESERVED_PLACEMENTS;
+	beam.reserve(config.beam_width);
+	children.reserve(most);
+	for (auto *v : {&heights, &holes, &bumpiness, &wells}) {
+		v->reserve(most);
+	}
+	scores.reserve(most);
+	order.reserve(most);
+}
+
+void BeamBot::expand(const Node &parent, PieceType type, const Pieces &after, bool hold) {
+	generate_placements(parent.board, type, placements);
+	for (const auto &p : placements) {
+		auto blocks = placement_blocks(p);
+		// a piece locked above the board loses, the search does not go there
+		bool lost = false;
+		for (const auto &b : blocks) {
+			lost |= b.pos.y < 0;
+		}
+		if (lost) {
+			continue;
+		}
+
+		Node &child = children.emplace_back();
+		child.board = parent.board;
+		child.board.place(blocks);
+		int cleared = clear_blocks(child.board, blocks).count;
+		child.pieces = after;
+		child.reward = parent.reward + config.weights.clears * calculate_score(cleared);
+		child.first = parent.depth == 0 ? BotMove{.hold = hold, .placement = p}
+										: parent.first;
+		child.depth = static_cast<uint8_t>(parent.depth + 1);
+	}
+}
+
+void BeamBot::evaluate() {
+	size_t n = children.size();
+	heights.resize(n);
+	holes.resize(n);
+	bumpiness.resize(n);
+	wells.resize(n);
+	scores.resize(n);
+
+	for (size_t i = 0; i < n; ++i) {
+		BoardFeatures f = board_features(children[i].board);
+		heights[i] = f.height;
+		holes[i] = f.holes;
+		bumpiness[i] = f.bumpiness;
+		wells[i] = f.wells;
+		scores[i] = children[i].reward;
+	}
+
+	const BotWeights &w = config.weights;
+	for (size_t i = 0; i < n; ++i) {
+		scores[i] += w.height * heights[i] + w.holes * holes[i] +
+					 w.bumpiness * bumpiness[i] + w.wells * wells[i];
+	}
+}
+
+// Key of a node for spotting the same position twice
+static uint64_t node_hash(const BeamBot::Node &node) {
+	const auto &p = node.pieces;
+	uint64_t pieces = p.active | p.hold << 3 | static_cast<unsigned>(p.has_hold) << 6 |
+					  static_cast<unsigned>(p.known) << 7 |
+					  static_cast<unsigned>(p.can_hold) << 8 |
+					  static_cast<unsigned>(p.next) << 9;
+	uint64_t h = zobrist_rows(node.board, 0, GRID_HEIGHT) ^
+				 ((pieces + 1) * 0x9e3779b97f4a7c15);
+	return h == 0 ? 1 : h;
+}
+
+void BeamBot::select() {
+	// only the best few are needed, twice the width leaves room for duplicates
+	size_t n = children.size();
+	size_t ranked = std::min(n, 2 * config.beam_width);
+	order.resize(n);
+	for (size_t i = 0; i < n; ++i) {
+		order[i] = static_cast<uint32_t>(i);
+	}
+	std::partial_sort(
+		order.begin(), order.begin() + static_cast<ptrdiff_t>(ranked), order.end(),
+		[this](uint32_t a, uint32_t b) { return scores[a] > scores[b]; }
+	);
+
+	std::fill(seen.begin(), seen.end(), 0);
+	size_t mask = seen.size() - 1;
+	beam.clear();
+	for (size_t i = 0; i < ranked && beam.size() < config.beam_width; ++i) {
+		const Node &child = children[order[i]];
+		uint64_t h = node_hash(child);
+		size_t slot = h & mask;
+		while (seen[slot] != 0 && seen[slot] != h) {
+			slot = (slot + 1) & mask;
+		}
+		if (seen[slot] == h) {
+			continue;
+		}
+		seen[slot] = h;
+		beam.push_back(child);
+	}
+}
+
+bool BeamBot::think(const GameState &state, BotMove &out) {
+	auto start = Clock::now();
+	preview_count = std::min(state.randomizer.preview_depth(), MAX_PREVIEW);
+	for (size_t i = 0; i < preview_count; ++i) {
+		preview[i] = state.randomizer.peek(i);
+	}
+
+	beam.clear();
+	Node &root = beam.emplace_back();
+	root.board = state.board;
+	root.pieces.active = state.tet.get_type();
+	root.pieces.has_hold = state.hold_tet.has_value();
+	root.pieces.can_hold = !state.held;
+	if (root.pieces.has_hold) {
+		root.pieces.hold = state.hold_tet->get_type();
+	}
+
+	bool found = false;
+	for (int level = 0; level < config.depth; ++level) {
+		children.clear();
+		bool late = false;
+		for (const Node &node : beam) {
+			// the first level always finishes, there has to be a move
+			if (level > 0 && config.budget.count() > 0 &&
+				Clock::now() - start > config.budget) {
+				late = true;
+				break;
+			}
+			const Pieces &at = node.pieces;
+			if (!at.known) {
+				continue;
+			}
+			// the piece after the one placed comes from the preview
+			auto advance = [this](Pieces pieces, size_t next) {
+				pieces.known = next < preview_count;
+				if (pieces.known) {
+					pieces.active = preview[next];
+				}
+				pieces.next = static_cast<uint8_t>(next + 1);
+				pieces.can_hold = true;
+				return pieces;
+			};
+
+			expand(node, at.active, advance(at, at.next), false);
+			if (!at.can_hold) {
+				continue;
+			}
+			Pieces held = at;
+			held.hold = at.active;
+			held.has_hold = true;
+			if (at.has_hold && at.hold != at.active) {
+				expand(node, at.hold, advance(held, at.next), true);
+			} else if (!at.has_hold && at.next < preview_count) {
+				// holding into an empty slot brings in the next piece
+				expand(node, preview[at.next], advance(held, at.next + 1U), true);
+			}
+		}
+		if (late || children.empty()) {
+			break;
+		}
+		evaluate();
+		select();
+		out = beam.front().first;
+		found = true;
+	}
+	if (found) {
+		return true;
+	}
+
+	// every placement loses, play one anyway
+	generate_placements(state.board, state.tet.get_type(), placements);
+	if (placements.count == 0) {
+		return false;
+	}
+	out = {.hold = false, .placement = placements.items[0]};
+	return true;
+}
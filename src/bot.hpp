@@ -0,0 +1,96 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "board.hpp"
+#include "game.hpp"
+#include "movegen.hpp"
+
+// Weights of the board heuristic of `BeamBot` and `GreedyPolicy`, per unit of each
+// feature. `evaluate_board` scores with them.
+struct BotWeights {
+	double height = -0.51;	  // summed column heights
+	double holes = -0.36;	  // empty cells with a filled cell above them
+	double bumpiness = -0.18; // height differences between neighbouring columns
+	double wells = -0.08;	  // cells of columns lower than both neighbours, by depth
+	double clears = 0.004;	  // `calculate_score` of every clear on the way
+};
+
+struct BotConfig {
+	// Positions kept after each piece, the best by the heuristic
+	size_t beam_width = 64;
+	// Pieces searched ahead, from the active one. At most the active piece, the
+	// held one and the preview are known, deeper than that the search stops.
+	int depth = 2;
+	// Time for one move, the search returns the best of the deepest finished
+	// level when it runs out. 0 for no limit.
+	std::chrono::microseconds budget{0};
+	BotWeights weights{};
+};
+
+// What to do with the active piece
+struct BotMove {
+	bool hold = false;	 // hold first, `placement` is then of the piece that comes in
+	Placement placement; // where the piece is locked
+};
+
+// Plays by beam search over piece placements. From the active piece on, each level
+// of the search places one more piece in every way `generate_placements` allows,
+// with or without holding first, and keeps the `beam_width` best boards for the
+// next level. Boards are scored by a weighted heuristic, a level's candidates as
+// one batch: the features of all of them first, then the weighted sums in one
+// loop over arrays. Positions reached twice, by holding in a different order, are
+// only kept once.
+//
+// Scratch space is kept between moves, a bot that has warmed up does not allocate.
+class BeamBot {
+  public:
+	// The pieces of a position in the search
+	struct Pieces {
+		PieceType active = PIECE_I;
+		PieceType hold = PIECE_I;
+		bool has_hold = false;
+		bool can_hold = true; // `active` was not held in, see `GameState::held`
+		bool known = true; // `active` is in the preview, the search can go on
+		uint8_t next = 0;  // index in the preview of the piece after `active`
+	};
+	struct Node {
+		Board board;
+		Pieces pieces;
+		double reward = 0; // clear rewards on the way here
+		BotMove first{};   // the move at the root this position came from
+		uint8_t depth = 0; // pieces placed since the root
+	};
+
+  private:
+	BotConfig config;
+	std::array<PieceType, MAX_PREVIEW> preview{};
+	size_t preview_count = 0;
+	std::vector<Node> beam;
+	std::vector<Node> children;
+	PlacementList placements;
+	// scratch of `evaluate` and `select`, by index into `children`
+	std::vector<int> heights, holes, bumpiness, wells;
+	std::vector<double> scores;
+	std::vector<uint32_t> order;
+	std::vector<uint64_t> seen; // open addressing set of position hashes
+
+	// Adds a child of `parent` for every placement of `type`, `after` are the
+	// pieces once it is placed.
+	void expand(const Node &parent, PieceType type, const Pieces &after, bool hold);
+	// Scores `children` into `scores`, as a batch.
+	void evaluate();
+	// Keeps the best distinct children as the next beam.
+	void select();
+
+  public:
+	explicit BeamBot(const BotConfig &bot_config = {});
+
+	// The best move for `state` by the search. Returns false when the active
+	// piece has nowhere to go.
+	bool think(const GameState &state, BotMove &out);
+};
@@ -1,9 +1,11 @@
 #include "collision.hpp"
 #include "tet.hpp"
 
-Collision check_all_collisions(Tetramino tet, std::vector<Block> board) {
-	auto base = check_collision(tet.blocks, board);
-	auto rotated = check_collision(tet.blocks, board);
+template <int W, int H>
+Collision check_all_collisions(const Tetramino &tet, const BasicBoard<W, H> &board) {
+	auto blocks = tet.blocks();
+	auto base = check_collision(blocks, board);
+	auto rotated = check_collision(blocks, board);
 
 	return Collision{
 		.base = base,
@@ -11,11 +13,13 @@ Collision check_all_collisions(Tetramino tet, std::vector<Block> board) {
 	};
 }
 
-CollisionBase check_collision(std::array<Block, 4> blocks, std::vector<Block> board) {
+template <int W, int H>
+CollisionBase
+check_collision(const std::array<Block, 4> &blocks, const BasicBoard<W, H> &board) {
 	CollisionBase col;
 	int lowest_y = 0;
 	int rightest_x = 0;
-	int leftest_x = GRID_HEIGHT - 1;
+	int leftest_x = W - 1;
 
 	for (size_t i = 0; i < 4; ++i) {
 		Coordinate t = blocks[i].pos;
@@ -30,28 +34,16 @@ CollisionBase check_collision(std::array<Block, 4> blocks, std::vector<Block> bo
 			leftest_x = t.x;
 		}
 
-		for (const auto &b : board) {
-			bool xMatch = t.x == b.pos.x;
-			if (xMatch && t.y == b.pos.y - 1) {
-				col.down = true;
-			}
-			if (xMatch && t.y == b.pos.y + 1) {
-				col.up = true;
-			}
-			bool yMatch = (t.y == b.pos.y);
-			if (yMatch && t.x == b.pos.x - 1) {
-				col.right = true;
-			}
-			if (yMatch && t.x == b.pos.x + 1) {
-				col.left = true;
-			}
-		}
+		col.down |= board.occupied(t.x, t.y + 1);
+		col.up |= board.occupied(t.x, t.y - 1);
+		col.right |= board.occupied(t.x + 1, t.y);
+		col.left |= board.occupied(t.x - 1, t.y);
 	}
 
-	if (lowest_y >= GRID_HEIGHT - 1) {
+	if (lowest_y >= H - 1) {
 		col.down = true;
 	}
-	if (rightest_x >= GRID_WIDTH - 1) {
+	if (rightest_x >= W - 1) {
 		col.right = true;
 	}
 	if (leftest_x <= 0) {
@@ -61,11 +53,14 @@ CollisionBase check_collision(std::array<Block, 4> blocks, std::vector<Block> bo
 	return col;
 }
 
-CollisionBase check_obstruction(std::array<Block, 4> blocks, std::vector<Block> board) {
+template <int W, int H>
+CollisionBase
+check_obstruction(const std::array<Block, 4> &blocks, const BasicBoard<W, H> &board) {
 	CollisionBase col;
 	int lowest_y = 0;
 	int rightest_x = 0;
-	int leftest_x = GRID_HEIGHT - 1;
+	int leftest_x = W - 1;
+	bool overlap = false;
 
 	for (size_t i = 0; i < 4; ++i) {
 		Coordinate t = blocks[i].pos;
@@ -80,28 +75,16 @@ CollisionBase check_obstruction(std::array<Block, 4> blocks, std::vector<Block>
 			leftest_x = t.x;
 		}
 
-		for (const auto &b : board) {
-			bool xMatch = t.x == b.pos.x;
-			if (xMatch && t.y == b.pos.y) {
-				col.down = true;
-			}
-			if (xMatch && t.y == b.pos.y) {
-				col.up = true;
-			}
-			bool yMatch = (t.y == b.pos.y);
-			if (yMatch && t.x == b.pos.x) {
-				col.right = true;
-			}
-			if (yMatch && t.x == b.pos.x) {
-				col.left = true;
-			}
-		}
+		overlap |= board.occupied(t.x, t.y);
 	}
 
-	if (lowest_y >= GRID_HEIGHT) {
+	// an overlapping block obstructs in every direction
+	col.up = col.down = col.left = col.right = overlap;
+
+	if (lowest_y >= H) {
 		col.down = true;
 	}
-	if (rightest_x >= GRID_WIDTH) {
+	if (rightest_x >= W) {
 		col.right = true;
 	}
 	if (leftest_x <= -1) {
@@ -110,3 +93,40 @@ CollisionBase check_obstruction(std::array<Block, 4> blocks, std::vector<Block>
 
 	return col;
 }
+
+template <int W, int H>
+std::optional<Coordinate> find_kick(
+	const BasicBoard<W, H> &board, PieceType type, const Kicks &kicks, size_t from,
+	size_t to, int x, int y
+) {
+	for (const auto &test : kicks[from]) {
+		if (!piece_obstructed(board, type, to, x + test.x, y + test.y)) {
+			return test;
+		}
+	}
+	return std::nullopt;
+}
+
+template CollisionBase check_collision(const std::array<Block, 4> &, const Board &);
+template CollisionBase
+check_collision(const std::array<Block, 4> &, const TrainingBoard &);
+template CollisionBase check_collision(const std::array<Block, 4> &, const BigBoard &);
+template CollisionBase check_collision(const std::array<Block, 4> &, const TowerBoard &);
+template CollisionBase check_obstruction(const std::array<Block, 4> &, const Board &);
+template CollisionBase
+check_obstruction(const std::array<Block, 4> &, const TrainingBoard &);
+template CollisionBase check_obstruction(const std::array<Block, 4> &, const BigBoard &);
+template CollisionBase
+check_obstruction(const std::array<Block, 4> &, const TowerBoard &);
+template Collision check_all_collisions(const Tetramino &, const Board &);
+template Collision check_all_collisions(const Tetramino &, const TrainingBoard &);
+template Collision check_all_collisions(const Tetramino &, const BigBoard &);
+template Collision check_all_collisions(const Tetramino &, const TowerBoard &);
+template std::optional<Coordinate>
+find_kick(const Board &, PieceType, const Kicks &, size_t, size_t, int, int);
+template std::optional<Coordinate>
+find_kick(const TrainingBoard &, PieceType, const Kicks &, size_t, size_t, int, int);
+template std::optional<Coordinate>
+find_kick(const BigBoard &, PieceType, const Kicks &, size_t, size_t, int, int);
+template std::optional<Coordinate>
+find_kick(const TowerBoard &, PieceType, const Kicks &, size_t, size_t, int, int);
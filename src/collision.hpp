@@ -1,6 +1,10 @@
 #pragma once
 
+#include <algorithm>
+#include <optional>
+
 #include "block.hpp"
+#include "board.hpp"
 #include "tet.hpp"
 
 struct CollisionBase {
@@ -15,8 +19,52 @@ struct Collision {
 	CollisionBase rotated;
 };
 
-CollisionBase check_collision(std::array<Block, 4> blocks, std::vector<Block> board);
+// The collision tests are instantiated in collision.cpp for the board aliases of
+// board.hpp, each with its walls and floor as constants.
+template <int W, int H>
+CollisionBase
+check_collision(const std::array<Block, 4> &blocks, const BasicBoard<W, H> &board);
+
+template <int W, int H>
+CollisionBase
+check_obstruction(const std::array<Block, 4> &blocks, const BasicBoard<W, H> &board);
+
+template <int W, int H>
+Collision check_all_collisions(const Tetramino &tet, const BasicBoard<W, H> &board);
+
+// Whether orientation `idx` of `type` with its offset at (`x`, `y`) overlaps the
+// board or sticks out through a wall or the floor. Same answer as
+// `check_obstruction`, but tested a pattern row at a time with the piece masks.
+// Inline, as the move generator calls it several times per searched state.
+template <int W, int H>
+inline bool piece_obstructed(
+	const BasicBoard<W, H> &board, PieceType type, size_t idx, int x, int y
+) {
+	const PieceDef &def = PIECES[type];
+	Coordinate lo = def.min_cell[idx];
+	Coordinate hi = def.max_cell[idx];
+	if (x + lo.x < 0 || x + hi.x >= W || y + hi.y >= H) {
+		return true;
+	}
 
-CollisionBase check_obstruction(std::array<Block, 4> blocks, std::vector<Block> board);
+	const auto &masks = def.masks[idx];
+	for (int r = std::max(lo.y, -y); r <= hi.y; ++r) {
+		// the wall test above keeps every block of the row inside the grid
+		auto cells = row_cells<typename BasicBoard<W, H>::Row>(
+			masks[static_cast<size_t>(r)], x
+		);
+		if (!row_empty(cells & board.row(y + r))) {
+			return true;
+		}
+	}
+	return false;
+}
 
-Collision check_all_collisions(Tetramino tet, std::vector<Block> board);
+// Runs the kick tests for turning `type` from orientation `from` to `to` with its
+// offset at (`x`, `y`). Returns the translation of the first test that fits, or
+// nothing when every test is obstructed.
+template <int W, int H>
+std::optional<Coordinate> find_kick(
+	const BasicBoard<W, H> &board, PieceType type, const Kicks &kicks, size_t from,
+	size_t to, int x, int y
+);
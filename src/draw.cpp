@@ -0,0 +1,105 @@
+#include "rlgl.h"
+
+#include "block_atlas.hpp"
+#include "draw.hpp"
+
+static Texture2D block_atlas;
+// Where each `BlockSprite` is in the atlas
+static std::array<Rectangle, 3> sprite_rects;
+
+void load_block_texture() {
+	// the pixels are only read, raylib takes them as non-const
+	Image atlas{
+		.data = const_cast<unsigned char *>(BLOCK_ATLAS_PIXELS),
+		.width = BLOCK_ATLAS_WIDTH,
+		.height = BLOCK_ATLAS_HEIGHT,
+		.mipmaps = 1,
+		.format = PIXELFORMAT_UNCOMPRESSED_GRAY_ALPHA,
+	};
+	for (size_t i = 0; i < sprite_rects.size(); ++i) {
+		auto size = static_cast<float>(BLOCK_ATLAS_SPRITE_SIZE[i]);
+		sprite_rects[i] = Rectangle{
+			.x = static_cast<float>(BLOCK_ATLAS_SPRITE_X[i]),
+			.y = 0,
+			.width = size,
+			.height = size,
+		};
+	}
+	block_atlas = LoadTextureFromImage(atlas);
+}
+void unload_block_texture() { UnloadTexture(block_atlas); }
+
+BlockBatch::BlockBatch() {
+	// the board, ghost, active piece and both previews
+	vertices.reserve(4 * (GRID_WIDTH * GRID_HEIGHT + 4 * 4));
+}
+
+void BlockBatch::add(
+	const Block &block, int x_margin, int y_margin, int x_offset, int y_offset,
+	BlockSprite sprite, float opacity
+) {
+	const Rectangle &src = sprite_rects[sprite];
+	auto x = static_cast<float>(
+		((block.pos.x + x_offset) * static_cast<int>(src.width)) + x_margin
+	);
+	auto y = static_cast<float>(
+		((block.pos.y + y_offset) * static_cast<int>(src.height)) + y_margin
+	);
+	auto atlas_w = static_cast<float>(block_atlas.width);
+	auto atlas_h = static_cast<float>(block_atlas.height);
+	float u0 = src.x / atlas_w;
+	float v0 = src.y / atlas_h;
+	float u1 = (src.x + src.width) / atlas_w;
+	float v1 = (src.y + src.height) / atlas_h;
+	Color color = ColorAlpha(BLOCK_COLORS[block.color], opacity);
+
+	// same winding as DrawTexturePro
+	vertices.push_back({.x = x, .y = y, .u = u0, .v = v0, .color = color});
+	vertices.push_back({.x = x, .y = y + src.height, .u = u0, .v = v1, .color = color});
+	vertices.push_back(
+		{.x = x + src.width, .y = y + src.height, .u = u1, .v = v1, .color = color}
+	);
+	vertices.push_back({.x = x + src.width, .y = y, .u = u1, .v = v0, .color = color});
+}
+
+void BlockBatch::add(
+	const std::array<Block, 4> &blocks, int x_margin, int y_margin, float opacity,
+	BlockSprite sprite
+) {
+	for (const auto &b : blocks) {
+		add(b, x_margin, y_margin, 0, 0, sprite, opacity);
+	}
+}
+
+void BlockBatch::add(const Board &board, int x_margin, int y_margin, float opacity) {
+	for (int y = 0; y < GRID_HEIGHT; ++y) {
+		if (board.row(y) == 0) {
+			continue;
+		}
+		for (int x = 0; x < GRID_WIDTH; ++x) {
+			if (board.occupied(x, y)) {
+				Block b{.pos = {.x = x, .y = y}, .color = board.color(x, y)};
+				add(b, x_margin, y_margin, 0, 0, SPRITE_BLOCK, opacity);
+			}
+		}
+	}
+}
+
+void BlockBatch::draw() const {
+	if (vertices.empty()) {
+		return;
+	}
+	// flush whatever raylib has batched so far, so the blocks go out in one call
+	rlDrawRenderBatchActive();
+	rlCheckRenderBatchLimit(static_cast<int>(vertices.size()));
+
+	rlSetTexture(block_atlas.id);
+	rlBegin(RL_QUADS);
+	for (const auto &v : vertices) {
+		rlColor4ub(v.color.r, v.color.g, v.color.b, v.color.a);
+		rlTexCoord2f(v.u, v.v);
+		rlVertex2f(v.x, v.y);
+	}
+	rlEnd();
+	rlSetTexture(0);
+}
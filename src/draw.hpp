@@ -0,0 +1,60 @@
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include "raylib.h"
+
+#include "block.hpp"
+#include "board.hpp"
+
+// raylib colors indexed by `BlockColor`
+const std::array<Color, 8> BLOCK_COLORS = {
+	BLANK, SKYBLUE, PURPLE, BLUE, ORANGE, YELLOW, RED, GREEN,
+};
+
+// Which of the block sprites in the atlas to draw
+enum BlockSprite {
+	SPRITE_BLOCK = 0,
+	SPRITE_MEDIUMBLOCK,
+	SPRITE_TINYBLOCK,
+};
+
+// Uploads the block atlas compiled into the binary (see atlas_gen.cpp) as one
+// texture.
+void load_block_texture();
+void unload_block_texture();
+
+struct BlockVertex {
+	float x, y;
+	float u, v;
+	Color color;
+};
+
+// Collects every block of a frame as tinted quads of the atlas, and draws them
+// all with a single draw call. The vertex buffer keeps its capacity between
+// frames, so a steady frame does not allocate.
+class BlockBatch {
+  private:
+	std::vector<BlockVertex> vertices;
+
+  public:
+	BlockBatch();
+
+	// Starts a new frame.
+	void clear() { vertices.clear(); }
+
+	void add(
+		const Block &block, int x_margin, int y_margin, int x_offset, int y_offset,
+		BlockSprite sprite, float opacity = 1
+	);
+	void add(
+		const std::array<Block, 4> &blocks, int x_margin, int y_margin,
+		float opacity = 1, BlockSprite sprite = SPRITE_BLOCK
+	);
+	void add(const Board &board, int x_margin, int y_margin, float opacity = 1);
+
+	// Submits the batch. Call after anything that should be drawn below the
+	// blocks, as text and shapes use other textures.
+	void draw() const;
+};
@@ -0,0 +1,287 @@
+#include <algorithm>
+
+#include "collision.hpp"
+#include "game.hpp"
+#include "position.hpp"
+#include "profiler.hpp"
+
+uint calculate_score(int cleared) {
+	switch (cleared) {
+	case 1:
+		return 50;
+	case 2:
+		return 200;
+	case 3:
+		return 400;
+	case 4:
+		return 800;
+	}
+	return 0;
+}
+
+Tetramino drop_ghost(const Tetramino &tet, const Board &board) {
+	auto ghost_tet = tet;
+	ghost_tet.move(0, board.drop_distance(tet.blocks()));
+	return ghost_tet;
+}
+
+// Gravity per frame at the base rate past the levels of the original curve
+const std::array<uint32_t, 9> FAST_GRAVITY = {
+	CELL / 5, CELL / 4, CELL / 3, CELL / 2, CELL, 2 * CELL, 5 * CELL, 10 * CELL,
+	GRAVITY_20G,
+};
+
+// Gravity per frame at the base rate as gravity per step at `tick_rate`. 20G stays
+// 20G, it drops the piece at once however often the game steps.
+static uint32_t per_step(uint32_t per_frame, int tick_rate) {
+	if (per_frame >= GRAVITY_20G) {
+		return GRAVITY_20G;
+	}
+	uint64_t gravity =
+		uint64_t{per_frame} * BASE_TICK_RATE / static_cast<uint64_t>(tick_rate);
+	return static_cast<uint32_t>(std::max<uint64_t>(1, gravity));
+}
+
+uint32_t level_gravity(uint difficulty, int tick_rate) {
+	if (difficulty < 12) {
+		return per_step(CELL / (40 - (3 * difficulty)), tick_rate);
+	}
+	size_t fast = std::min<size_t>(difficulty - 12, FAST_GRAVITY.size() - 1);
+	return per_step(FAST_GRAVITY[fast], tick_rate);
+}
+
+// Gravity of a game at its difficulty, the configured one when there is one
+static uint32_t step_gravity(const GameState &st) {
+	if (st.config.gravity == 0) {
+		return level_gravity(st.difficulty, st.tick_rate);
+	}
+	return per_step(st.config.gravity, st.tick_rate);
+}
+
+GameState::GameState(uint32_t seed, int rate, const GravityConfig &gravity_config)
+	: randomizer{seed}, tick_rate{rate}, config{gravity_config} {
+	gravity = step_gravity(*this);
+	lock_resets_left = config.lock_resets;
+}
+
+Game::Game() { st.hash = position_hash(st); }
+
+Game::Game(uint32_t seed, int tick_rate, const GravityConfig &gravity)
+	: st{seed, tick_rate, gravity} {
+	st.hash = position_hash(st);
+}
+
+Tetramino Game::ghost() const { return drop_ghost(st.tet, st.board); }
+
+void Game::spawn() {
+	st.hash ^= zobrist_piece(st.tet) ^ zobrist_queue(st.randomizer);
+	st.tet = Tetramino(st.randomizer.draw());
+	st.hash ^= zobrist_piece(st.tet) ^ zobrist_queue(st.randomizer);
+	st.held = false;
+	reset_lock();
+}
+
+void Game::reset_lock() {
+	st.fall_progress = 0;
+	st.lock_time = 0;
+	st.lock_resets_left = st.config.lock_resets;
+	st.lowest_y = st.tet.get_y_offset();
+}
+
+void Game::lock(StepResult &res) {
+	// the rows of the piece and, when it clears, the rows above it down from the
+	// top of the stack are all the lock can change
+	int top = GRID_HEIGHT;
+	int bottom = -1;
+	for (int x = 0; x < GRID_WIDTH; ++x) {
+		top = std::min(top, st.board.surface_y(x));
+	}
+	const auto blocks = st.tet.blocks();
+	for (const auto &b : blocks) {
+		top = std::min(top, b.pos.y);
+		bottom = std::max(bottom, b.pos.y);
+	}
+	top = std::max(top, 0);
+	bottom = std::min(bottom + 1, GRID_HEIGHT);
+	uint64_t rows_before = zobrist_rows(st.board, top, bottom);
+
+	st.board.place(blocks);
+	res.locked = true;
+	{
+		ProfileScope scope{PHASE_CLEAR};
+		res.cleared = clear_blocks(st.board, blocks);
+	}
+	st.hash ^= rows_before ^ zobrist_rows(st.board, top, bottom);
+	if (res.cleared.count > 0) {
+		st.score += calculate_score(res.cleared.count);
+	}
+	// fail if placed tet is above 0
+	for (size_t i = 0; i < 4; ++i) {
+		if (blocks[i].pos.y < 0) {
+			st.over = true;
+			res.over = true;
+			return;
+		}
+	}
+
+	spawn();
+
+	st.difficulty = (st.score / 500);
+	st.gravity = step_gravity(st);
+}
+
+static Collision timed_collisions(const Tetramino &tet, const Board &board) {
+	ProfileScope scope{PHASE_COLLISION};
+	return check_all_collisions(tet, board);
+}
+
+StepResult Game::step(Inputs inputs) {
+	ProfileScope scope{PHASE_STEP};
+	StepResult res{};
+	if (st.over) {
+		res.over = true;
+		return res;
+	}
+
+	const uint64_t piece_before = zobrist_piece(st.tet);
+	const size_t idx_before = st.tet.get_pattern_idx();
+	const int x_before = st.tet.get_x_offset();
+	// every move changes what the piece touches, the collisions are taken again
+	// after each so a soft drop tests the column the piece ended up in
+	auto col = timed_collisions(st.tet, st.board);
+	if ((inputs & INPUT_LEFT) && !col.base.left) {
+		st.tet.left();
+		col = timed_collisions(st.tet, st.board);
+	}
+	if ((inputs & INPUT_RIGHT) && !col.base.right) {
+		st.tet.right();
+		col = timed_collisions(st.tet, st.board);
+	}
+	if (inputs & (INPUT_LEFT_WALL | INPUT_RIGHT_WALL)) {
+		int dx = (inputs & INPUT_LEFT_WALL) ? -1 : 1;
+		const int x = st.tet.get_x_offset();
+		const int y = st.tet.get_y_offset();
+		int moved = 0;
+		while (!piece_obstructed(
+			st.board, st.tet.get_type(), st.tet.get_pattern_idx(), x + moved + dx, y
+		)) {
+			moved += dx;
+		}
+		st.tet.move(moved, 0);
+		col = timed_collisions(st.tet, st.board);
+	}
+	if ((inputs & INPUT_SOFT_DROP) && !col.base.down) {
+		st.tet.fall();
+		st.fall_progress = 0;
+	}
+	if (inputs & INPUT_ROTATE) {
+		st.tet.rotate_ccw(st.board);
+	}
+	// moved sideways or turned, a piece on the ground gets more time to lock
+	const bool moved =
+		st.tet.get_x_offset() != x_before || st.tet.get_pattern_idx() != idx_before;
+
+	// instantly replace tetramino with ghost tetramino, and lock it
+	if (inputs & INPUT_HARD_DROP) {
+		st.tet = ghost();
+		st.hash ^= piece_before ^ zobrist_piece(st.tet);
+		lock(res);
+		return res;
+	}
+	st.hash ^= piece_before ^ zobrist_piece(st.tet);
+
+	if (inputs & INPUT_HOLD) {
+		swap_hold();
+	}
+
+	fall(moved, res);
+	return res;
+}
+
+void Game::fall(bool moved, StepResult &res) {
+	// however many cells gravity adds up to, the piece moves once, as far as it
+	// gets before it lands
+	int room = st.board.drop_distance(st.tet.blocks());
+	st.fall_progress += st.gravity;
+	int cells = static_cast<int>(st.fall_progress / CELL);
+	st.fall_progress %= CELL;
+	if (cells > 0 && room > 0) {
+		int distance = std::min(cells, room);
+		st.hash ^= zobrist_piece(st.tet);
+		st.tet.move(0, distance);
+		st.hash ^= zobrist_piece(st.tet);
+		room -= distance;
+		++st.cycle_count;
+		res.gravity = true;
+	}
+	if (st.tet.get_y_offset() > st.lowest_y) {
+		st.lowest_y = st.tet.get_y_offset();
+		st.lock_time = 0;
+		st.lock_resets_left = st.config.lock_resets;
+	}
+	if (room > 0) {
+		st.lock_time = 0;
+		return;
+	}
+
+	// on the ground, nothing more to fall
+	st.fall_progress = 0;
+	if (moved && st.lock_resets_left > 0) {
+		--st.lock_resets_left;
+		st.lock_time = 0;
+	}
+	++st.lock_time;
+	int delay = st.config.lock_delay_ms * st.tick_rate / 1000;
+	if (st.lock_time > delay) {
+		lock(res);
+	}
+}
+
+void Game::swap_hold() {
+	// holding back and forth would keep a piece from ever locking
+	if (st.held) {
+		return;
+	}
+	auto temp = st.tet;
+	st.hash ^= zobrist_hold(st.hold_tet) ^ zobrist_hold(temp);
+
+	if (st.hold_tet.has_value()) {
+		st.hash ^= zobrist_piece(st.tet);
+		st.tet.set_type(st.hold_tet->get_type());
+		// the held shape can stick through a wall or into the stack where the
+		// active one fit, it then comes in at spawn instead
+		if (piece_obstructed(
+				st.board, st.tet.get_type(), st.tet.get_pattern_idx(),
+				st.tet.get_x_offset(), st.tet.get_y_offset()
+			)) {
+			st.tet = Tetramino(st.tet.get_type());
+		}
+		st.hash ^= zobrist_piece(st.tet);
+		st.hold_tet = temp;
+		reset_lock();
+	} else {
+		spawn();
+		st.hold_tet = temp;
+	}
+	st.held = true;
+}
+
+void Game::hold() {
+	if (!st.over) {
+		swap_hold();
+	}
+}
+
+StepResult Game::place(const Placement &placement) {
+	StepResult res{};
+	if (st.over) {
+		res.over = true;
+		return res;
+	}
+
+	Tetramino tet(placement.type, placement.idx, placement.x, placement.y);
+	st.hash ^= zobrist_piece(st.tet) ^ zobrist_piece(tet);
+	st.tet = tet;
+	lock(res);
+	return res;
+}
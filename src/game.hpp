@@ -0,0 +1,147 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <sys/types.h>
+
+#include "board.hpp"
+#include "movegen.hpp"
+#include "randomizer.hpp"
+#include "tet.hpp"
+
+// Actions requested for a single step, one bit each. A frontend sets the bit for
+// every key pressed during the step.
+enum Input : uint8_t {
+	INPUT_NONE = 0,
+	INPUT_LEFT = 1 << 0,
+	INPUT_RIGHT = 1 << 1,
+	INPUT_SOFT_DROP = 1 << 2,
+	INPUT_ROTATE = 1 << 3,
+	INPUT_HARD_DROP = 1 << 4,
+	INPUT_HOLD = 1 << 5,
+	// as far left or right as the piece goes, for auto repeat without a delay
+	INPUT_LEFT_WALL = 1 << 6,
+	INPUT_RIGHT_WALL = 1 << 7,
+};
+typedef uint8_t Inputs;
+
+// Steps per second the original game loop ran at, the rules were tuned for it
+const int BASE_TICK_RATE = 60;
+
+// Gravity is counted in fixed point fractions of a cell
+const uint32_t CELL = 1 << 16;
+// Drops a piece to the floor in a single step, the board is not that tall
+const uint32_t GRAVITY_20G = 20 * CELL;
+
+// How pieces fall and lock
+struct GravityConfig {
+	// Cells per frame at the base rate, in 1/`CELL`. 0 follows the level curve.
+	uint32_t gravity = 0;
+	// How long a piece on the ground waits before it locks
+	int lock_delay_ms = 500;
+	// Moves and rotations on the ground that start the lock delay over, per piece.
+	// Reaching a row lower than before gives them all back.
+	int lock_resets = 15;
+};
+
+// Cells a piece falls per step at `difficulty`, in 1/`CELL`, when stepping
+// `tick_rate` times a second. One cell per 40 frames at the base rate, 3 frames
+// fewer per level down to 7, then faster and faster up to 20G.
+uint32_t level_gravity(uint difficulty, int tick_rate);
+
+struct GameState {
+	// upcoming pieces, the next one is `randomizer.peek(0)`
+	Randomizer randomizer{};
+	Board board{};
+	std::optional<Tetramino> hold_tet;
+	Tetramino tet{randomizer.draw()};
+	// the active piece came in through a hold, it cannot be held again
+	bool held = false;
+
+	int tick_rate = BASE_TICK_RATE; // steps per second
+	GravityConfig config{};
+	// cells per step in 1/`CELL`, see `level_gravity`
+	uint32_t gravity = CELL / 40;
+	uint32_t fall_progress = 0; // part of a cell fallen since the last whole one
+	// lock delay of the active piece: steps on the ground, resets left and the
+	// lowest offset reached
+	int lock_time = 0;
+	int lock_resets_left = config.lock_resets;
+	int lowest_y = SPAWN_Y;
+	uint difficulty = 0;
+	uint score = 0;
+	uint64_t cycle_count = 0; // steps gravity moved the piece
+	bool over = false;
+	// `position_hash` of the state, `Game` keeps it up to date
+	uint64_t hash = 0;
+
+	GameState() = default;
+	// A state whose pieces only depend on `seed`, stepped `rate` times a second
+	explicit GameState(
+		uint32_t seed, int rate = BASE_TICK_RATE, const GravityConfig &gravity_config = {}
+	);
+};
+
+// What happened during a step, for the frontend to react to (logging, sound).
+struct StepResult {
+	bool gravity = false; // gravity moved the piece down this step
+	bool locked = false;  // the active piece was settled on the board
+	LineClear cleared{};  // rows cleared by the lock
+	bool over = false;	  // the locked piece was out of bounds, the game is lost
+};
+
+uint calculate_score(int cleared);
+
+// `tet` moved straight down as far as it goes on `board`.
+Tetramino drop_ghost(const Tetramino &tet, const Board &board);
+
+// The rules of the game without any input polling or drawing. One `step` is one
+// frame of the original game loop, so gravity and lock delay are counted in steps.
+//
+// Gravity adds to a fixed point fall counter every step, each whole cell in it is
+// fallen at once. However many cells that is, the piece moves straight to where
+// it lands or as far as it gets, read off the board's surface, never a cell at a
+// time. A piece on the ground locks after the lock delay, a move or rotation
+// starts the delay over as long as it has resets left.
+class Game {
+  private:
+	GameState st{};
+
+	// Settles the active piece, clears rows, scores and spawns the next piece.
+	void lock(StepResult &res);
+	// Draws the next piece as the active one.
+	void spawn();
+	// Starts the lock delay over for a new piece
+	void reset_lock();
+	// Lets the piece fall by the gravity of one step, and locks it once it has been
+	// on the ground for the lock delay.
+	void fall(bool moved, StepResult &res);
+	// Swaps the active piece with the held one, or with the next piece when none
+	// is held. Once per piece, does nothing when the active piece was held in.
+	void swap_hold();
+
+  public:
+	// A game with pieces from a random seed
+	Game();
+	// A game whose pieces only depend on `seed`. With the same inputs it plays out
+	// the same way every time. Gravity is counted in steps, it falls at the speed
+	// of the original game when stepped `tick_rate` times a second.
+	explicit Game(
+		uint32_t seed, int tick_rate = BASE_TICK_RATE, const GravityConfig &gravity = {}
+	);
+
+	// Advances the game by one step. Does nothing once the game is over.
+	StepResult step(Inputs inputs);
+	// Locks the active piece at `placement` right away, for players that pick
+	// placements from `generate_placements` instead of pressing keys. `placement`
+	// must be of the active piece type.
+	StepResult place(const Placement &placement);
+	// Holds the active piece right away, as `INPUT_HOLD` does, for the same players.
+	// Like it, only once per piece.
+	void hold();
+
+	const GameState &state() const { return st; }
+
+	// Where the active piece would land if dropped now.
+	Tetramino ghost() const;
+};
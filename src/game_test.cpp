@@ -0,0 +1,95 @@
+// Checks of the game rules, run by ctest. Prints every failed check and exits
+// non-zero when there was one.
+
+#include <cstdint>
+#include <cstdio>
+#include <random>
+
+#include "collision.hpp"
+#include "game.hpp"
+
+static int failures = 0;
+
+static void check(bool ok, const char *what, uint32_t seed, int step) {
+	if (!ok) {
+		std::printf("FAIL %s (seed %u, step %d)\n", what, seed, step);
+		++failures;
+	}
+}
+
+static bool active_obstructed(const GameState &st) {
+	return piece_obstructed(
+		st.board, st.tet.get_type(), st.tet.get_pattern_idx(), st.tet.get_x_offset(),
+		st.tet.get_y_offset()
+	);
+}
+
+// Moving sideways and soft dropping in one step must test the drop from the
+// column the piece moved to. A piece floated at the left wall makes an overhang,
+// the next piece comes at it from the right at every height.
+static void diagonal_soft_drop() {
+	for (uint32_t seed = 0; seed < 20; ++seed) {
+		for (int height = 0; height < GRID_HEIGHT; ++height) {
+			// barely any gravity, the piece only comes down by soft drop
+			Game game{seed, BASE_TICK_RATE, GravityConfig{.gravity = 1}};
+			game.place({
+				.type = game.state().tet.get_type(),
+				.idx = 0,
+				.x = 0,
+				.y = 6,
+			});
+			game.step(INPUT_RIGHT_WALL);
+			for (int step = 0; step < height; ++step) {
+				game.step(INPUT_SOFT_DROP);
+			}
+			for (int step = 0; step < GRID_WIDTH && !game.state().over; ++step) {
+				auto inputs = static_cast<Inputs>(INPUT_LEFT | INPUT_SOFT_DROP);
+				if (!game.step(inputs).locked) {
+					check(
+						!active_obstructed(game.state()),
+						"left and soft drop into the stack", seed, step
+					);
+				}
+			}
+		}
+	}
+}
+
+// Random inputs, the moves pressed together most often included, never put the
+// active piece into the stack or through a wall.
+static void random_inputs() {
+	const Inputs choices[] = {
+		static_cast<Inputs>(INPUT_LEFT | INPUT_SOFT_DROP),
+		static_cast<Inputs>(INPUT_RIGHT | INPUT_SOFT_DROP),
+		static_cast<Inputs>(INPUT_LEFT | INPUT_ROTATE),
+		static_cast<Inputs>(INPUT_RIGHT | INPUT_ROTATE),
+		INPUT_LEFT_WALL,
+		INPUT_RIGHT_WALL,
+		INPUT_HOLD,
+		INPUT_HARD_DROP,
+		INPUT_NONE,
+	};
+	for (uint32_t seed = 0; seed < 50; ++seed) {
+		Game game{seed};
+		std::mt19937 rng{seed};
+		std::uniform_int_distribution<size_t> pick(0, std::size(choices) - 1);
+		for (int step = 0; step < 20000 && !game.state().over; ++step) {
+			// a new piece can spawn into a stack that reached the top, the game
+			// only ends once it locks
+			if (!game.step(choices[pick(rng)]).locked) {
+				check(!active_obstructed(game.state()), "random inputs", seed, step);
+			}
+		}
+	}
+}
+
+int main() {
+	diagonal_soft_drop();
+	random_inputs();
+	if (failures > 0) {
+		std::printf("%d checks failed\n", failures);
+		return 1;
+	}
+	std::printf("all checks passed\n");
+	return 0;
+}
@@ -0,0 +1,90 @@
+#include <algorithm>
+#include <chrono>
+
+#include "input.hpp"
+
+const std::array<Inputs, BUTTON_COUNT> BUTTON_INPUTS = {
+	INPUT_LEFT, INPUT_RIGHT, INPUT_SOFT_DROP, INPUT_ROTATE, INPUT_HARD_DROP, INPUT_HOLD,
+};
+
+static uint64_t ms_to_ns(int ms) { return static_cast<uint64_t>(ms) * 1000000; }
+
+uint64_t input_now() {
+	auto ns = std::chrono::steady_clock::now().time_since_epoch();
+	return static_cast<uint64_t>(
+		std::chrono::duration_cast<std::chrono::nanoseconds>(ns).count()
+	);
+}
+
+bool InputQueue::push(const InputEvent &ev) {
+	uint32_t t = tail.load(std::memory_order_relaxed);
+	if (t - head.load(std::memory_order_acquire) == CAPACITY) {
+		return false;
+	}
+	events[t % CAPACITY] = ev;
+	tail.store(t + 1, std::memory_order_release);
+	return true;
+}
+
+bool InputQueue::pop(InputEvent &out) {
+	uint32_t h = head.load(std::memory_order_relaxed);
+	if (h == tail.load(std::memory_order_acquire)) {
+		return false;
+	}
+	out = events[h % CAPACITY];
+	head.store(h + 1, std::memory_order_release);
+	return true;
+}
+
+void InputHandler::event(const InputEvent &ev) {
+	if (ev.button >= BUTTON_COUNT || held[ev.button] == ev.down) {
+		return;
+	}
+	held[ev.button] = ev.down;
+
+	bool sideways = ev.button == BUTTON_LEFT || ev.button == BUTTON_RIGHT;
+	if (ev.down) {
+		pressed |= BUTTON_INPUTS[ev.button];
+		if (sideways) {
+			shift = ev.button;
+			shift_next = ev.time_ns + ms_to_ns(config.das_ms);
+		}
+		if (ev.button == BUTTON_SOFT_DROP) {
+			soft_drop_next = ev.time_ns + ms_to_ns(config.soft_drop_ms);
+		}
+	} else if (sideways && shift == ev.button) {
+		// fall back to the other direction if it is still held, charging again
+		Button other = ev.button == BUTTON_LEFT ? BUTTON_RIGHT : BUTTON_LEFT;
+		shift = held[other] ? other : BUTTON_COUNT;
+		shift_next = ev.time_ns + ms_to_ns(config.das_ms);
+	}
+}
+
+Inputs InputHandler::step(uint64_t now_ns) {
+	Inputs inputs = pressed;
+	pressed = INPUT_NONE;
+
+	if (shift != BUTTON_COUNT && now_ns >= shift_next) {
+		if (config.arr_ms <= 0) {
+			// every step, so a new piece goes straight to the wall as well
+			inputs |= shift == BUTTON_LEFT ? INPUT_LEFT_WALL : INPUT_RIGHT_WALL;
+		} else {
+			inputs |= BUTTON_INPUTS[shift];
+			// one move per step at most, repeats missed between two steps are dropped
+			// but later ones keep their timing
+			uint64_t arr = ms_to_ns(config.arr_ms);
+			while (shift_next <= now_ns) {
+				shift_next += arr;
+			}
+		}
+	}
+
+	if (held[BUTTON_SOFT_DROP] && now_ns >= soft_drop_next) {
+		inputs |= INPUT_SOFT_DROP;
+		uint64_t interval = ms_to_ns(std::max(1, config.soft_drop_ms));
+		while (soft_drop_next <= now_ns) {
+			soft_drop_next += interval;
+		}
+	}
+	return inputs;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "game.hpp"
+
+// Physical controls, each maps to one `Input`
+enum Button : uint8_t {
+	BUTTON_LEFT = 0,
+	BUTTON_RIGHT,
+	BUTTON_SOFT_DROP,
+	BUTTON_ROTATE,
+	BUTTON_HARD_DROP,
+	BUTTON_HOLD,
+	BUTTON_COUNT,
+};
+
+// A button going down or up, stamped with `input_now` when it was seen.
+struct InputEvent {
+	uint64_t time_ns;
+	Button button;
+	bool down;
+};
+
+// Nanoseconds on the clock input events and ticks are compared on
+uint64_t input_now();
+
+// Auto repeat of held buttons, in milliseconds
+struct HandlingConfig {
+	// delayed auto shift: how long left or right is held before it repeats
+	int das_ms = 167;
+	// auto repeat rate: time between repeats once shifting. 0 moves to the wall at
+	// once.
+	int arr_ms = 33;
+	// time between falls while soft drop is held
+	int soft_drop_ms = 50;
+};
+
+// Hands input events from the thread that polls the keys to the thread that runs
+// the game, without locks. One producer and one consumer.
+class InputQueue {
+  private:
+	static constexpr uint32_t CAPACITY = 256;
+	std::array<InputEvent, CAPACITY> events{};
+	alignas(64) std::atomic<uint32_t> head{0}; // next to pop, consumer only writes
+	alignas(64) std::atomic<uint32_t> tail{0}; // next to push, producer only writes
+
+  public:
+	// Returns false, dropping `ev`, when the queue is full.
+	bool push(const InputEvent &ev);
+	bool pop(InputEvent &out);
+};
+
+// Turns button events into the inputs of each step. A press acts on the next step.
+// Held left or right repeats after DAS every ARR, held soft drop repeats every
+// `soft_drop_ms`, all timed from the event timestamps rather than from when steps
+// happen to run, so the timing is as exact as the step rate allows.
+class InputHandler {
+  private:
+	HandlingConfig config;
+	std::array<bool, BUTTON_COUNT> held{};
+	Inputs pressed = INPUT_NONE; // presses since the last step
+	// the held direction that repeats, the most recently pressed one
+	Button shift = BUTTON_COUNT;
+	uint64_t shift_next = 0;
+	uint64_t soft_drop_next = 0;
+
+  public:
+	explicit InputHandler(const HandlingConfig &handling) : config{handling} {}
+
+	// Events must come in time order.
+	void event(const InputEvent &ev);
+	// The inputs of a step run at `now_ns`.
+	Inputs step(uint64_t now_ns);
+};
@@ -0,0 +1,277 @@
+// Plays many games on a tetris_server at once, for load testing it.
+//
+// usage: tetris_loadgen [-p port | -u socket] [-c connections] [-g games]
+//                       [-t seconds]
+//
+// Joins `games` games (10000) spread over `connections` connections (8) and
+// presses a random key in each about every ten steps at 60 steps a second. A lost
+// game is left and joined again, so the load holds. Every diff is applied to a
+// view of its game. After `seconds` (10) it prints what arrived, and how many diffs
+// were malformed or came out of step order, both of which should never happen.
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <poll.h>
+#include <random>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+#include "net.hpp"
+#include "protocol.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+	Endpoint endpoint{};
+	size_t connections = 8;
+	size_t games = 10000;
+	int seconds = 10;
+};
+
+struct ClientGame {
+	size_t conn = 0;
+	uint32_t id = NO_GAME;
+	uint32_t last_step = 0;
+	GameView view{};
+};
+
+struct ClientConnection {
+	int fd = -1;
+	FrameReader in;
+	std::vector<uint8_t> out;
+	size_t sent = 0;
+	std::deque<size_t> joining; // games waiting for their MSG_JOINED, in order
+};
+
+struct Totals {
+	uint64_t joined = 0;
+	uint64_t refused = 0;
+	uint64_t diffs = 0;
+	uint64_t bytes = 0;
+	uint64_t lost = 0;
+	uint64_t malformed = 0;
+	uint64_t out_of_order = 0;
+};
+
+static const std::array<Inputs, 5> KEYS = {
+	INPUT_LEFT, INPUT_RIGHT, INPUT_ROTATE, INPUT_SOFT_DROP, INPUT_HARD_DROP,
+};
+
+static void join(ClientConnection &c, size_t game, uint32_t seed) {
+	write_join(c.out, seed);
+	c.joining.push_back(game);
+}
+
+// Returns false when the server closed the connection.
+static bool send_pending(ClientConnection &c) {
+	while (c.sent < c.out.size()) {
+		ssize_t n = send(c.fd, c.out.data() + c.sent, c.out.size() - c.sent, 0);
+		if (n < 0) {
+			return errno == EAGAIN || errno == EWOULDBLOCK;
+		}
+		c.sent += static_cast<size_t>(n);
+	}
+	c.out.clear();
+	c.sent = 0;
+	return true;
+}
+
+static void handle(
+	ClientConnection &c, const uint8_t *body, size_t len, std::vector<ClientGame> &games,
+	std::vector<size_t> &by_id, Totals &totals, std::mt19937 &rng
+) {
+	uint32_t id = 0;
+	uint32_t step = 0;
+	if (read_joined(body, len, id)) {
+		if (c.joining.empty()) {
+			++totals.malformed;
+			return;
+		}
+		size_t game = c.joining.front();
+		c.joining.pop_front();
+		if (id == NO_GAME) {
+			++totals.refused;
+			return;
+		}
+		++totals.joined;
+		if (by_id.size() <= id) {
+			by_id.resize(id + 1, games.size());
+		}
+		by_id[id] = game;
+		games[game].id = id;
+		games[game].last_step = 0;
+		games[game].view = GameView{};
+	} else if (read_diff_header(body, len, id, step)) {
+		if (id >= by_id.size() || by_id[id] >= games.size()) {
+			++totals.malformed;
+			return;
+		}
+		size_t game = by_id[id];
+		ClientGame &g = games[game];
+		++totals.diffs;
+		if (step <= g.last_step) {
+			++totals.out_of_order;
+		}
+		g.last_step = step;
+		if (!apply_diff(body, len, g.view)) {
+			++totals.malformed;
+			return;
+		}
+		if (g.view.over) {
+			++totals.lost;
+			write_leave(c.out, id);
+			by_id[id] = games.size();
+			g.id = NO_GAME;
+			join(c, game, static_cast<uint32_t>(rng()));
+		}
+	} else {
+		++totals.malformed;
+	}
+}
+
+static bool parse_options(int argc, char **argv, Options &opt) {
+	for (int i = 1; i < argc; ++i) {
+		if (i + 1 >= argc || argv[i][0] != '-' || std::strlen(argv[i]) != 2) {
+			return false;
+		}
+		const char *value = argv[++i];
+		switch (argv[i - 1][1]) {
+		case 'p':
+			opt.endpoint.port = static_cast<uint16_t>(std::strtoul(value, nullptr, 10));
+			break;
+		case 'u':
+			opt.endpoint.unix_path = value;
+			break;
+		case 'c':
+			opt.connections = std::strtoull(value, nullptr, 10);
+			break;
+		case 'g':
+			opt.games = std::strtoull(value, nullptr, 10);
+			break;
+		case 't':
+			opt.seconds = std::atoi(value);
+			break;
+		default:
+			return false;
+		}
+	}
+	return opt.connections > 0 && opt.games > 0 && opt.seconds > 0;
+}
+
+int main(int argc, char **argv) {
+	Options opt{};
+	if (!parse_options(argc, argv, opt)) {
+		std::fprintf(
+			stderr,
+			"usage: %s [-p port | -u socket] [-c connections] [-g games] [-t seconds]\n",
+			argv[0]
+		);
+		return 1;
+	}
+	std::signal(SIGPIPE, SIG_IGN);
+
+	std::mt19937 rng(1);
+	std::vector<ClientConnection> conns(opt.connections);
+	std::vector<ClientGame> games(opt.games);
+	std::vector<size_t> by_id; // index in `games` by server game id
+	for (auto &c : conns) {
+		c.fd = connect_to(opt.endpoint);
+		if (c.fd < 0 || !set_nonblocking(c.fd)) {
+			std::perror("connect");
+			return 1;
+		}
+		set_nodelay(c.fd);
+	}
+	for (size_t g = 0; g < games.size(); ++g) {
+		games[g].conn = g % conns.size();
+		join(conns[games[g].conn], g, static_cast<uint32_t>(rng()));
+	}
+
+	Totals totals{};
+	std::vector<pollfd> fds(conns.size());
+	const auto period = std::chrono::microseconds(1000000 / BASE_TICK_RATE);
+	auto start = Clock::now();
+	auto next_tick = start;
+	while (Clock::now() - start < std::chrono::seconds(opt.seconds)) {
+		auto now = Clock::now();
+		if (now >= next_tick) {
+			next_tick += period;
+			for (const auto &g : games) {
+				if (g.id != NO_GAME && rng() % 10 == 0) {
+					write_input(conns[g.conn].out, g.id, KEYS[rng() % KEYS.size()]);
+				}
+			}
+		}
+
+		for (size_t i = 0; i < conns.size(); ++i) {
+			if (!send_pending(conns[i])) {
+				std::fprintf(stderr, "the server closed a connection\n");
+				return 1;
+			}
+			fds[i] = {.fd = conns[i].fd, .events = POLLIN, .revents = 0};
+			if (!conns[i].out.empty()) {
+				fds[i].events |= POLLOUT;
+			}
+		}
+		auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(
+			next_tick - Clock::now()
+		);
+		int timeout = static_cast<int>(std::max<int64_t>(wait.count(), 0));
+		poll(fds.data(), fds.size(), timeout);
+
+		for (size_t i = 0; i < conns.size(); ++i) {
+			ClientConnection &c = conns[i];
+			if (!(fds[i].revents & (POLLIN | POLLHUP | POLLERR))) {
+				continue;
+			}
+			const size_t chunk = 65536;
+			ssize_t n = 0;
+			while ((n = recv(c.fd, c.in.reserve(chunk), chunk, 0)) > 0) {
+				c.in.received(static_cast<size_t>(n));
+				totals.bytes += static_cast<uint64_t>(n);
+				const uint8_t *body = nullptr;
+				size_t len = 0;
+				while (c.in.next(body, len)) {
+					handle(c, body, len, games, by_id, totals, rng);
+				}
+			}
+			if (n == 0 || c.in.broken()) {
+				std::fprintf(stderr, "the server closed a connection\n");
+				return 1;
+			}
+		}
+	}
+	double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+	std::printf(
+		"%llu joined (%llu refused), %llu lost and joined again\n",
+		static_cast<unsigned long long>(totals.joined),
+		static_cast<unsigned long long>(totals.refused),
+		static_cast<unsigned long long>(totals.lost)
+	);
+	std::printf(
+		"%.0f diffs/s, %.2f MB/s in, %.1f bytes/diff\n",
+		static_cast<double>(totals.diffs) / seconds,
+		static_cast<double>(totals.bytes) / seconds / 1e6,
+		static_cast<double>(totals.bytes) /
+			static_cast<double>(std::max<uint64_t>(1, totals.diffs))
+	);
+	std::printf(
+		"%llu malformed, %llu out of order\n",
+		static_cast<unsigned long long>(totals.malformed),
+		static_cast<unsigned long long>(totals.out_of_order)
+	);
+	for (auto &c : conns) {
+		close(c.fd);
+	}
+	return totals.malformed == 0 && totals.out_of_order == 0 ? 0 : 2;
+}
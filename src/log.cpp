@@ -0,0 +1,184 @@
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cinttypes>
+#include <thread>
+
+#include "log.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+// Records waiting for the log thread. At worst a burst of this many between two
+// wake ups of the log thread is kept, anything past it is dropped.
+const size_t LOG_RING_SIZE = 4096;
+// How long the log thread sleeps when the ring is empty
+const auto LOG_IDLE_WAIT = std::chrono::milliseconds(5);
+
+const std::array<const char *, 4> LEVEL_NAMES = {"DEBUG", "INFO", "WARNING", "ERROR"};
+
+struct LogEntry {
+	const char *format;
+	uint64_t time_ns;
+	LogLevel level;
+	uint8_t count;
+	std::array<LogArg, LOG_MAX_ARGS> args;
+};
+
+// Bounded queue for many producers and one consumer, after Dmitry Vyukov's. Each
+// slot carries a sequence number saying whose turn it is: a producer claims a slot
+// by moving `tail` on, fills it and then hands it to the consumer through the
+// sequence, so no thread ever waits on another.
+class LogRing {
+  private:
+	struct Slot {
+		std::atomic<uint64_t> seq;
+		LogEntry entry;
+	};
+	std::array<Slot, LOG_RING_SIZE> slots;
+	alignas(64) std::atomic<uint64_t> tail{0}; // next slot to claim
+	alignas(64) uint64_t head = 0;				// next slot to read, consumer only
+
+  public:
+	std::atomic<uint64_t> dropped{0};
+
+	LogRing() {
+		for (size_t i = 0; i < slots.size(); ++i) {
+			slots[i].seq.store(i, std::memory_order_relaxed);
+		}
+	}
+
+	bool push(const LogEntry &entry) {
+		uint64_t pos = tail.load(std::memory_order_relaxed);
+		for (;;) {
+			Slot &slot = slots[pos % LOG_RING_SIZE];
+			uint64_t seq = slot.seq.load(std::memory_order_acquire);
+			auto diff = static_cast<int64_t>(seq - pos);
+			if (diff == 0) {
+				if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+					slot.entry = entry;
+					slot.seq.store(pos + 1, std::memory_order_release);
+					return true;
+				}
+			} else if (diff < 0) {
+				// the consumer has not freed the slot a lap ago, the ring is full
+				dropped.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			} else {
+				pos = tail.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	bool pop(LogEntry &out) {
+		Slot &slot = slots[head % LOG_RING_SIZE];
+		if (slot.seq.load(std::memory_order_acquire) != head + 1) {
+			return false;
+		}
+		out = slot.entry;
+		slot.seq.store(head + LOG_RING_SIZE, std::memory_order_release);
+		++head;
+		return true;
+	}
+};
+
+static LogRing ring;
+static const Clock::time_point log_start = Clock::now();
+static std::thread log_thread;
+static std::atomic<bool> log_running{false};
+
+void log_record(LogLevel level, const char *format, const LogArg *args, size_t count) {
+	LogEntry entry{
+		.format = format,
+		.time_ns = static_cast<uint64_t>(
+			std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - log_start)
+				.count()
+		),
+		.level = level,
+		.count = static_cast<uint8_t>(count),
+		.args = {},
+	};
+	for (size_t i = 0; i < count; ++i) {
+		entry.args[i] = args[i];
+	}
+	ring.push(entry);
+}
+
+static void write_arg(FILE *out, const LogArg &arg) {
+	switch (arg.type) {
+	case ARG_INT:
+		std::fprintf(out, "%" PRId64, static_cast<int64_t>(arg.bits));
+		break;
+	case ARG_UINT:
+		std::fprintf(out, "%" PRIu64, arg.bits);
+		break;
+	case ARG_DOUBLE:
+		std::fprintf(out, "%g", std::bit_cast<double>(arg.bits));
+		break;
+	case ARG_BOOL:
+		std::fputs(arg.bits != 0 ? "true" : "false", out);
+		break;
+	case ARG_STRING:
+		std::fputs(reinterpret_cast<const char *>(arg.bits), out);
+		break;
+	}
+}
+
+static void write_entry(FILE *out, const LogEntry &entry) {
+	std::fprintf(
+		out, "[%10.6f] %s: ", static_cast<double>(entry.time_ns) / 1e9,
+		LEVEL_NAMES[entry.level]
+	);
+	size_t arg = 0;
+	for (const char *c = entry.format; *c != '\0'; ++c) {
+		if (c[0] == '{' && c[1] == '}' && arg < entry.count) {
+			write_arg(out, entry.args[arg++]);
+			++c;
+		} else {
+			std::fputc(*c, out);
+		}
+	}
+	std::fputc('\n', out);
+}
+
+// Writes out everything in the ring, returns false when it was empty
+static bool drain(FILE *out) {
+	LogEntry entry{};
+	bool wrote = false;
+	while (ring.pop(entry)) {
+		write_entry(out, entry);
+		wrote = true;
+	}
+	uint64_t dropped = ring.dropped.exchange(0, std::memory_order_relaxed);
+	if (dropped > 0) {
+		std::fprintf(
+			out, "%" PRIu64 " log records dropped, the ring was full\n", dropped
+		);
+		wrote = true;
+	}
+	if (wrote) {
+		std::fflush(out);
+	}
+	return wrote;
+}
+
+void start_log_thread(FILE *out) {
+	if (log_running.exchange(true)) {
+		return;
+	}
+	log_thread = std::thread([out] {
+		while (log_running.load(std::memory_order_acquire)) {
+			if (!drain(out)) {
+				std::this_thread::sleep_for(LOG_IDLE_WAIT);
+			}
+		}
+		drain(out);
+	});
+}
+
+void stop_log_thread() {
+	log_running.store(false, std::memory_order_release);
+	if (log_thread.joinable()) {
+		log_thread.join();
+	}
+}
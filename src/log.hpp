@@ -0,0 +1,122 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <type_traits>
+
+// Logging that keeps formatting and writing off the threads that log. A call
+// copies its format pointer and raw arguments into a lock-free ring, a background
+// thread formats them and writes them out. Calls below `TETRIS_LOG_LEVEL` compile
+// to nothing.
+//
+//     log_info("cleared {} rows, score {}", count, score);
+//
+// Formats are string literals with a `{}` per argument, checked at compile time.
+// Arguments are numbers, enums, bools and strings. Strings are kept as pointers,
+// they have to outlive the logger, like literals and `argv` do.
+enum LogLevel : uint8_t {
+	LEVEL_DEBUG = 0,
+	LEVEL_INFO,
+	LEVEL_WARNING,
+	LEVEL_ERROR,
+};
+
+// Lowest level compiled in, set from CMake with -DTETRIS_LOG_LEVEL=<0-3>
+#ifndef TETRIS_LOG_LEVEL
+#ifdef NDEBUG
+#define TETRIS_LOG_LEVEL 1
+#else
+#define TETRIS_LOG_LEVEL 0
+#endif
+#endif
+
+const size_t LOG_MAX_ARGS = 4;
+
+enum LogArgType : uint8_t {
+	ARG_INT = 0,
+	ARG_UINT,
+	ARG_DOUBLE,
+	ARG_BOOL,
+	ARG_STRING,
+};
+
+struct LogArg {
+	LogArgType type;
+	uint64_t bits;
+};
+
+template <class T> LogArg log_arg(const T &value) {
+	if constexpr (std::is_same_v<T, bool>) {
+		return {.type = ARG_BOOL, .bits = value};
+	} else if constexpr (std::is_enum_v<T>) {
+		return log_arg(static_cast<std::underlying_type_t<T>>(value));
+	} else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+		auto bits = static_cast<uint64_t>(static_cast<int64_t>(value));
+		return {.type = ARG_INT, .bits = bits};
+	} else if constexpr (std::is_integral_v<T>) {
+		return {.type = ARG_UINT, .bits = static_cast<uint64_t>(value)};
+	} else if constexpr (std::is_floating_point_v<T>) {
+		auto bits = std::bit_cast<uint64_t>(static_cast<double>(value));
+		return {.type = ARG_DOUBLE, .bits = bits};
+	} else {
+		static_assert(std::is_convertible_v<T, const char *>, "cannot log this type");
+		auto bits = reinterpret_cast<uintptr_t>(static_cast<const char *>(value));
+		return {.type = ARG_STRING, .bits = bits};
+	}
+}
+
+// A format string that has a `{}` for every one of `Args`, anything else does not
+// compile.
+template <class... Args> struct LogFormat {
+	const char *text;
+
+	template <size_t N> consteval LogFormat(const char (&format)[N]) : text{format} {
+		size_t holes = 0;
+		for (size_t i = 0; i + 1 < N; ++i) {
+			if (format[i] == '{' && format[i + 1] == '}') {
+				++holes;
+			}
+		}
+		if (holes != sizeof...(Args)) {
+			throw "a log format needs one {} per argument";
+		}
+	}
+};
+
+// Queues a record for the log thread. Never blocks or allocates, a record that
+// finds the ring full is dropped and counted.
+void log_record(LogLevel level, const char *format, const LogArg *args, size_t count);
+
+template <LogLevel L, class... Args>
+void log_at(std::type_identity_t<LogFormat<Args...>> format, const Args &...args) {
+	static_assert(sizeof...(Args) <= LOG_MAX_ARGS, "too many log arguments");
+	if constexpr (L >= TETRIS_LOG_LEVEL) {
+		const LogArg packed[sizeof...(Args) + 1] = {log_arg(args)...};
+		log_record(L, format.text, packed, sizeof...(Args));
+	}
+}
+
+template <class... Args>
+void log_debug(std::type_identity_t<LogFormat<Args...>> format, const Args &...args) {
+	log_at<LEVEL_DEBUG, Args...>(format, args...);
+}
+template <class... Args>
+void log_info(std::type_identity_t<LogFormat<Args...>> format, const Args &...args) {
+	log_at<LEVEL_INFO, Args...>(format, args...);
+}
+template <class... Args>
+void log_warning(std::type_identity_t<LogFormat<Args...>> format, const Args &...args) {
+	log_at<LEVEL_WARNING, Args...>(format, args...);
+}
+template <class... Args>
+void log_error(std::type_identity_t<LogFormat<Args...>> format, const Args &...args) {
+	log_at<LEVEL_ERROR, Args...>(format, args...);
+}
+
+// Starts the thread that writes records to `out`. Records logged before it starts
+// wait in the ring.
+void start_log_thread(FILE *out);
+// Writes out what is left in the ring and stops the thread.
+void stop_log_thread();
@@ -1,12 +1,26 @@
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <format>
-#include <vector>
+#include <optional>
+#include <random>
 
 #include "raylib.h"
 
+#include "alloc_count.hpp"
 #include "block.hpp"
-#include "collision.hpp"
+#include "board.hpp"
+#include "bot.hpp"
+#include "draw.hpp"
+#include "game.hpp"
+#include "input.hpp"
+#include "log.hpp"
+#include "position.hpp"
+#include "profiler.hpp"
+#include "replay.hpp"
+#include "simulation.hpp"
 #include "tet.hpp"
-using std::vector;
 
 const int FPS_TARGET = 60;
 
@@ -27,205 +41,505 @@ const Rectangle right_margin{
 };
 
 static uint score = 0;
+static bool show_debug = false;
+
+// set from the command line, only the first game is recorded or replayed
+static ReplayWriter recorder{};
+static ReplayReader replay{};
+static bool replaying = false;
+static int tick_rate = 240;
+static GravityConfig gravity{};
+static HandlingConfig handling{};
+// pieces a second the bot plays at, 0 when a human plays
+static int demo_rate = 0;
+
+// Feeds the simulation from the keyboard, the replay or the bot, records and logs
+// its ticks. Runs on the simulation thread.
+class FrontendHooks : public SimulationHooks {
+  public:
+	bool next_inputs(Inputs pressed, Inputs &out) override {
+		if (demo_rate > 0) {
+			out = INPUT_NONE;
+			return true;
+		}
+		if (!replaying) {
+			out = pressed;
+			return true;
+		}
+		if (!replay.next(replayed)) {
+			return false;
+		}
+		out = replayed.inputs;
+		return true;
+	}
 
-uint calculate_score(int cleared) {
-	switch (cleared) {
-	case 1:
-		return 50;
-	case 2:
-		return 200;
-	case 3:
-		return 400;
-	case 4:
-		return 800;
+	// In demo mode the piece falls on its own until it is time for the next one,
+	// then the bot puts it where it wants it.
+	bool autoplay(Game &game, StepResult &res) override {
+		if (demo_rate <= 0 || ++demo_ticks < tick_rate / demo_rate) {
+			return false;
+		}
+		demo_ticks = 0;
+		BotMove move{};
+		if (!bot.think(game.state(), move)) {
+			return false;
+		}
+		if (move.hold) {
+			game.hold();
+		}
+		res = game.place(move.placement);
+		return true;
 	}
-	return 0;
+
+	void stepped(Inputs inputs, const StepResult &res, const GameState &st) override {
+		recorder.record(inputs, st);
+		if (replaying && replayed.check && state_hash(st) != replayed.hash) {
+			log_warning("replay desync at step {}", replay.steps() - 1);
+		}
+
+		if (res.gravity) {
+			log_debug("cycle: {}", st.cycle_count);
+		}
+		if (res.cleared.count > 0) {
+			log_info("Cleared {} rows! score: {}", res.cleared.count, st.score);
+		}
+		if (res.locked && !res.over) {
+			log_info("difficulty: {}, score: {}", st.difficulty, st.score);
+		}
+	}
+
+  private:
+	ReplayStep replayed{};
+	// made before the game starts, so its scratch space is too
+	BeamBot bot{demo_config()};
+	int demo_ticks = 0;
+
+	static BotConfig demo_config() {
+		BotConfig config{};
+		// half a tick to think, so the bot never holds the simulation up
+		config.budget = std::chrono::microseconds(500000 / tick_rate);
+		return config;
+	}
+};
+
+// Formats into `buf` without allocating, cutting the text short if it does not fit.
+template <size_t N, class... Args>
+const char *
+format_text(std::array<char, N> &buf, std::format_string<Args...> fmt, Args &&...args) {
+	auto res = std::format_to_n(
+		buf.data(), static_cast<std::ptrdiff_t>(N - 1), fmt, std::forward<Args>(args)...
+	);
+	*res.out = '\0';
+	return buf.data();
 }
 
-void draw_next_tet(Tetramino tet) {
+void draw_next_tet(BlockBatch &batch, const Tetramino &tet) {
 	DrawText("Next:", WINDOW_WIDTH_MARGIN_START + 8, 8, 20, WHITE);
-	for (size_t i = 0; i < 4; ++i) {
-		tet.blocks[i].draw_medium(
-			WINDOW_WIDTH_MARGIN_START - 8, 20, -tet.get_x_offset(), -tet.get_y_offset()
+	for (const auto &b : tet.blocks()) {
+		batch.add(
+			b,
+			WINDOW_WIDTH_MARGIN_START - 8,
+			20,
+			-tet.get_x_offset(),
+			-tet.get_y_offset(),
+			SPRITE_MEDIUMBLOCK
 		);
 	}
 }
-void draw_hold_tet(std::optional<Tetramino> tet) {
+void draw_hold_tet(BlockBatch &batch, const std::optional<Tetramino> &tet) {
 	DrawText("Hold:", WINDOW_WIDTH_MARGIN_START + 8, 80, 20, WHITE);
 	if (tet.has_value()) {
-		for (size_t i = 0; i < 4; ++i) {
-			tet.value().blocks[i].draw_medium(
+		for (const auto &b : tet.value().blocks()) {
+			batch.add(
+				b,
 				WINDOW_WIDTH_MARGIN_START - 8,
 				92,
 				-tet.value().get_x_offset(),
-				-tet.value().get_y_offset()
+				-tet.value().get_y_offset(),
+				SPRITE_MEDIUMBLOCK
 			);
 		}
 	}
 }
 
-// returns true when window should close.
-bool game() {
-	uint64_t cycle_count = 0;
-	int game_time = 0;
-	int frames_per_fall = 40; // reduce this to increase speed and difficulty
-	uint difficulty = 0;	  // reduce this to increase speed and difficulty
-	vector<Block> blocks{};
-	std::optional<Tetramino> hold_tet;
-	Tetramino next_tet = create_random_tet();
-	Tetramino tet = create_random_tet();
-	Collision col{};
-	int rotated_count = 0;
-
-	// game loop
-	while (!WindowShouldClose()) {
-		vector<Block> total_blocks = blocks;
-		total_blocks.insert(
-			total_blocks.begin(), std::begin(tet.blocks), std::end(tet.blocks)
-		);
+// keyboard keys of each button
+const std::array<int, BUTTON_COUNT> BUTTON_KEYS = {
+	KEY_H, KEY_L, KEY_J, KEY_R, KEY_SPACE, KEY_S,
+};
 
-		col = check_all_collisions(tet, blocks);
-		if (IsKeyPressed(KEY_H) && !col.base.left) {
-			tet.left();
-		}
-		if (IsKeyPressed(KEY_L) && !col.base.right) {
-			tet.right();
-		}
-		if (IsKeyPressed(KEY_J) && !col.base.down) {
-			tet.fall();
-			game_time = 0;
-		}
-		if (IsKeyPressed(KEY_R)) {
-			tet.rotate_ccw(blocks);
-			if (rotated_count < 3) {
-				game_time = game_time / 2;
+// Pushes the button changes raylib saw in its last event poll, at `polled_at`.
+// Presses come from raylib's key queue, so a tap that went down and up between two
+// polls still counts.
+void poll_buttons(
+	Simulation &sim, std::array<bool, BUTTON_COUNT> &held, uint64_t polled_at
+) {
+	for (int key = GetKeyPressed(); key != 0; key = GetKeyPressed()) {
+		for (size_t b = 0; b < BUTTON_COUNT; ++b) {
+			if (BUTTON_KEYS[b] == key && !held[b]) {
+				held[b] = sim.push({polled_at, static_cast<Button>(b), true});
 			}
-
-			++rotated_count;
 		}
-
-		// draw a ghost tetramino where it would land (draw happens below)
-		auto ghost_tet = tet;
-		while (!(check_collision(ghost_tet.blocks, blocks).down)) {
-			ghost_tet.fall();
-		}
-		// instantly replace tetramino with ghost tetramino, (place it immediately)
-		if (IsKeyPressed(KEY_SPACE)) {
-			tet = ghost_tet;
-			game_time = frames_per_fall - 1;
+	}
+	for (size_t b = 0; b < BUTTON_COUNT; ++b) {
+		if (held[b] && IsKeyUp(BUTTON_KEYS[b])) {
+			held[b] = !sim.push({polled_at, static_cast<Button>(b), false});
 		}
+	}
+}
 
-		if (IsKeyPressed(KEY_S)) {
-			auto temp = tet;
+// Text of the game screen, formatted without allocating
+struct HudText {
+	std::array<char, 32> level{};
+	std::array<char, 32> score{};
+	std::array<char, 48> debug{};
+	std::array<std::array<char, 64>, PHASE_COUNT> phases{};
+};
 
-			if (hold_tet.has_value()) {
-				tet.set_pattern(hold_tet->get_pattern(), hold_tet->blocks[0].color);
-				hold_tet = temp;
-			} else {
-				tet = next_tet;
-				hold_tet = temp;
-				next_tet = create_random_tet();
-			}
-		}
-		col = check_all_collisions(tet, blocks);
+// What the static layer is drawn from, it is redrawn when any of it changes
+struct LayerKey {
+	uint64_t board = 0; // hash of the settled rows
+	uint score = 0;
+	uint difficulty = 0;
+	PieceType next = PIECE_I;
+	std::optional<PieceType> hold;
 
-		if (game_time != 0 && game_time >= frames_per_fall) {
-			game_time = 0;
-			rotated_count = 0;
-			++cycle_count;
-			TraceLog(LOG_INFO, "cycle: %d", cycle_count);
-			if (!col.base.down) {
-				TraceLog(LOG_INFO, "Collision down");
-				tet.fall();
+	bool operator==(const LayerKey &) const = default;
+};
 
-			} else {
-				int cleared;
-				tie(cleared, total_blocks) = clear_blocks(total_blocks);
-				if (cleared > 0) {
-					score += calculate_score(cleared);
-					TraceLog(LOG_INFO, "Cleared %d rows! score: %d\n", cleared, score);
-				}
-				// fail if placed tet is above 0
-				for (size_t i = 0; i < 4; ++i) {
-					if (tet.blocks[i].pos.y < 0) {
-						return false;
-					}
-				}
-
-				blocks = total_blocks;
-				tet = next_tet;
-				next_tet = create_random_tet();
-
-				difficulty = (score / 500);
-
-				printf("difficulty:%d, score: %d\n", difficulty, score);
-				frames_per_fall = std::max(5, 40 - (3 * static_cast<int>(difficulty)));
-			}
-		}
+static LayerKey layer_key(const GameState &st) {
+	LayerKey key{
+		.board = zobrist_rows(st.board, 0, GRID_HEIGHT),
+		.score = st.score,
+		.difficulty = st.difficulty,
+		.next = st.randomizer.peek(0),
+		.hold = std::nullopt,
+	};
+	if (st.hold_tet.has_value()) {
+		key.hold = st.hold_tet->get_type();
+	}
+	return key;
+}
 
-		// TraceLog(LOG_INFO, "frame: %d\n", game_time);
-		BeginDrawing();
-		ClearBackground(GRAY);
-		DrawRectangleRec(right_margin, DARKGRAY);
-		DrawText(
-			std::format("level:\n{}", difficulty).c_str(),
-			WINDOW_WIDTH_MARGIN_START + 4,
-			WINDOW_HEIGHT_MARGIN_START - 24,
-			16,
-			WHITE
+// Everything on the game screen but the active piece and its ghost: the
+// background, the side panel with its text and previews, and the settled board.
+// It only changes on locks, so it is drawn into a texture once per change and
+// copied to the screen every frame.
+struct StaticLayer {
+	RenderTexture2D target{};
+	LayerKey key{};
+	bool valid = false; // `target` holds the layer of `key`
+};
+static StaticLayer layer{};
+
+void draw_static_layer(BlockBatch &batch, const GameState &st, HudText &text) {
+	batch.clear();
+	ClearBackground(GRAY);
+	DrawRectangleRec(right_margin, DARKGRAY);
+	DrawText(
+		format_text(text.level, "level:\n{}", st.difficulty),
+		WINDOW_WIDTH_MARGIN_START + 4,
+		WINDOW_HEIGHT_MARGIN_START - 24,
+		16,
+		WHITE
+	);
+	DrawText(
+		format_text(text.score, "score:\n{}", st.score),
+		WINDOW_WIDTH_MARGIN_START + 4,
+		WINDOW_HEIGHT_MARGIN_START + 24,
+		16,
+		WHITE
+	);
+	draw_next_tet(batch, Tetramino(st.randomizer.peek(0)));
+	draw_hold_tet(batch, st.hold_tet);
+	// draw dotted line
+	for (int i = 0; i < 16; i += 2) {
+		int length = WINDOW_WIDTH / 20;
+		DrawLineEx(
+			Vector2{.x = static_cast<float>(length * i), .y = WINDOW_HEIGHT_MARGIN},
+			Vector2{
+				.x = static_cast<float>(length * (i + 1)), .y = WINDOW_HEIGHT_MARGIN
+			},
+			2,
+			DARKGRAY
 		);
+	}
+
+	batch.add(st.board, 0, WINDOW_HEIGHT_MARGIN);
+	batch.draw();
+}
+
+// Redraws the static layer when `st` changed any of it. Call outside of
+// `BeginDrawing`.
+void update_static_layer(BlockBatch &batch, const GameState &st, HudText &text) {
+	LayerKey key = layer_key(st);
+	if (layer.valid && key == layer.key) {
+		return;
+	}
+	BeginTextureMode(layer.target);
+	draw_static_layer(batch, st, text);
+	EndTextureMode();
+	layer.key = key;
+	layer.valid = true;
+}
+
+void draw_game(BlockBatch &batch, const Snapshot &snap) {
+	// render textures are stored bottom up, the negative height flips it back
+	DrawTextureRec(
+		layer.target.texture,
+		Rectangle{
+			.x = 0,
+			.y = 0,
+			.width = static_cast<float>(WINDOW_WIDTH),
+			.height = -static_cast<float>(WINDOW_HEIGHT),
+		},
+		Vector2{.x = 0, .y = 0},
+		WHITE
+	);
+	batch.clear();
+	batch.add(snap.ghost.blocks(), 0, WINDOW_HEIGHT_MARGIN, 0.2F);
+	batch.add(snap.state.tet.blocks(), 0, WINDOW_HEIGHT_MARGIN);
+	batch.draw();
+}
+
+// Frame time per phase, only shown while profiling
+void draw_phase_stats(const std::array<PhaseStats, PHASE_COUNT> &stats, HudText &text) {
+	for (size_t i = 0; i < PHASE_COUNT; ++i) {
 		DrawText(
-			std::format("score:\n{}", score).c_str(),
-			WINDOW_WIDTH_MARGIN_START + 4,
-			WINDOW_HEIGHT_MARGIN_START + 24,
-			16,
+			format_text(
+				text.phases[i],
+				"{:<10} p50 {:>8.1f}us  p99 {:>8.1f}us",
+				PHASE_NAMES[i],
+				static_cast<double>(stats[i].p50_ns) / 1000.0,
+				static_cast<double>(stats[i].p99_ns) / 1000.0
+			),
+			4,
+			16 + 10 * static_cast<int>(i),
+			10,
 			WHITE
 		);
-		draw_next_tet(next_tet);
-		draw_hold_tet(hold_tet);
-		// draw dotted line
-		for (int i = 0; i < 16; i += 2) {
-			int length = WINDOW_WIDTH / 20;
-			DrawLineEx(
-				Vector2{.x = static_cast<float>(length * i), .y = WINDOW_HEIGHT_MARGIN},
-				Vector2{
-					.x = static_cast<float>(length * (i + 1)), .y = WINDOW_HEIGHT_MARGIN
-				},
-				2,
-				DARKGRAY
-			);
+	}
+}
+
+// returns true when window should close.
+bool game(uint32_t seed) {
+	FrontendHooks hooks{};
+	Simulation sim{seed, tick_rate, gravity, handling, hooks};
+	BlockBatch batch{};
+	HudText text{};
+	std::array<PhaseStats, PHASE_COUNT> phase_stats{};
+	uint64_t frame_allocs = 0;
+	uint64_t frame = 0;
+	std::array<bool, BUTTON_COUNT> held{};
+	// when raylib last polled the keyboard, which it does at the end of each frame
+	uint64_t polled_at = input_now();
+	layer.valid = false;
+	sim.start();
+
+	// game loop, nothing of ours in here should allocate. The game itself runs on
+	// the simulation thread, this only passes keys to it and draws what it
+	// publishes.
+	while (!WindowShouldClose()) {
+		ProfileScope frame_scope{PHASE_FRAME};
+		// the simulation thread allocates on its own, only this thread's count is
+		// the render loop's
+		uint64_t allocs_before = thread_allocation_count();
+		if (IsKeyPressed(KEY_F3)) {
+			show_debug = !show_debug;
+		}
+		if (IsKeyPressed(KEY_F4)) {
+			set_profiling(!profiling());
+		}
+		if (IsKeyPressed(KEY_P)) {
+			// nothing moves while paused, frames are only drawn when input comes in
+			sim.set_paused(!sim.is_paused());
+			if (sim.is_paused()) {
+				EnableEventWaiting();
+			} else {
+				DisableEventWaiting();
+			}
 		}
 
-		draw_blocks(ghost_tet.blocks, 0, WINDOW_HEIGHT_MARGIN, 0.2F);
+		// keys pressed while paused are not played once the game resumes
+		if (!sim.is_paused()) {
+			ProfileScope scope{PHASE_INPUT};
+			poll_buttons(sim, held, polled_at);
+		}
 
-		draw_blocks(total_blocks, 0, WINDOW_HEIGHT_MARGIN);
-		EndDrawing();
-		++game_time;
+		const Snapshot &snap = sim.latest();
+		score = snap.state.score;
+		if (snap.finished) {
+			DisableEventWaiting();
+			return false;
+		}
+
+		// percentiles take a while to work out, twice a second is enough to read
+		bool show_phases = show_debug && profiling();
+		if (show_phases && frame % 30 == 0) {
+			profile_stats(phase_stats);
+		}
+		++frame;
+
+		{
+			ProfileScope scope{PHASE_DRAW};
+			update_static_layer(batch, snap.state, text);
+			BeginDrawing();
+			draw_game(batch, snap);
+			if (sim.is_paused()) {
+				DrawText("PAUSED", (WINDOW_WIDTH / 2) - 48, WINDOW_HEIGHT / 2, 24, WHITE);
+			}
+			if (show_debug) {
+				DrawText(
+					format_text(text.debug, "allocs/frame: {}", frame_allocs),
+					4,
+					4,
+					10,
+					WHITE
+				);
+			}
+			if (show_phases) {
+				draw_phase_stats(phase_stats, text);
+			}
+		}
+		// counted up to here, presenting polls events and swaps buffers in GLFW and
+		// the GL driver, which may allocate as they please. The core is held to no
+		// allocations by tetris_bench.
+		frame_allocs = thread_allocation_count() - allocs_before;
+		if (frame_allocs > 0) {
+			log_warning("frame allocated {} times", frame_allocs);
+		}
+		{
+			ProfileScope scope{PHASE_PRESENT};
+			EndDrawing();
+		}
+		polled_at = input_now();
 	}
+	DisableEventWaiting();
 	return true;
 }
 
-int main() {
+// usage: tetris [--record <file> | --replay <file>] [--profile <trace.json>]
+//               [--tick-rate <steps per second>] [--das <ms>] [--arr <ms>]
+//               [--soft-drop <ms>] [--gravity <cells per frame>]
+//               [--lock-delay <ms>] [--lock-resets <count>]
+//               [--demo <pieces per second>]
+//
+// --profile turns the frame profiler on from the start and writes what it last
+// recorded as a Chrome trace on exit. F4 turns the profiler on and off, F3 shows
+// its numbers, P pauses. The game steps 240 times a second unless --tick-rate says
+// otherwise, a replay always plays at the rate it was recorded at. --das, --arr
+// and --soft-drop set how held keys repeat, an ARR of 0 shifts straight to the wall.
+// --gravity fixes the speed pieces fall at instead of following the level, in cells
+// per frame at 60 frames a second, 20 drops them at once. --lock-delay and
+// --lock-resets set how long a piece on the ground takes to lock, and how many
+// moves and rotations start that over. --demo lets the built in bot play instead of
+// the keyboard, up to one piece a tick.
+int main(int argc, char **argv) {
+	std::random_device rd;
+	uint32_t seed = rd();
+	const char *record_path = nullptr;
+	const char *trace_path = nullptr;
+	bool valid = true;
+	for (int i = 1; i < argc && valid; i += 2) {
+		const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+		if (value == nullptr) {
+			valid = false;
+		} else if (std::strcmp(argv[i], "--record") == 0) {
+			record_path = value;
+		} else if (std::strcmp(argv[i], "--replay") == 0) {
+			if (!replay.load(value)) {
+				std::fprintf(
+					stderr, "%s: not a replay of version %d\n", value, REPLAY_VERSION
+				);
+				return 1;
+			}
+			replaying = true;
+		} else if (std::strcmp(argv[i], "--profile") == 0) {
+			trace_path = value;
+			set_profiling(true);
+		} else if (std::strcmp(argv[i], "--tick-rate") == 0) {
+			tick_rate = std::atoi(value);
+			valid = tick_rate >= 1 && tick_rate <= 10000;
+		} else if (std::strcmp(argv[i], "--das") == 0) {
+			handling.das_ms = std::atoi(value);
+			valid = handling.das_ms >= 0;
+		} else if (std::strcmp(argv[i], "--arr") == 0) {
+			handling.arr_ms = std::atoi(value);
+			valid = handling.arr_ms >= 0;
+		} else if (std::strcmp(argv[i], "--soft-drop") == 0) {
+			handling.soft_drop_ms = std::atoi(value);
+			valid = handling.soft_drop_ms >= 0;
+		} else if (std::strcmp(argv[i], "--gravity") == 0) {
+			double cells = std::atof(value);
+			valid = cells > 0 && cells <= 20;
+			gravity.gravity = static_cast<uint32_t>(cells * CELL);
+		} else if (std::strcmp(argv[i], "--lock-delay") == 0) {
+			gravity.lock_delay_ms = std::atoi(value);
+			valid = gravity.lock_delay_ms >= 0;
+		} else if (std::strcmp(argv[i], "--lock-resets") == 0) {
+			gravity.lock_resets = std::atoi(value);
+			valid = gravity.lock_resets >= 0;
+		} else if (std::strcmp(argv[i], "--demo") == 0) {
+			demo_rate = std::atoi(value);
+			valid = demo_rate >= 1;
+		} else {
+			valid = false;
+		}
+	}
+	// demo games are not recorded, the bot does not play through inputs
+	bool demo_conflict = demo_rate > 0 && (replaying || record_path != nullptr);
+	if (!valid || (replaying && record_path != nullptr) || demo_conflict) {
+		std::fprintf(
+			stderr,
+			"usage: %s [--record <file> | --replay <file>] [--profile <trace.json>] "
+			"[--tick-rate <steps per second>] [--das <ms>] [--arr <ms>] "
+			"[--soft-drop <ms>] [--gravity <cells per frame>] [--lock-delay <ms>] "
+			"[--lock-resets <count>] [--demo <pieces per second>]\n",
+			argv[0]
+		);
+		return 1;
+	}
+	if (replaying) {
+		seed = replay.seed();
+		tick_rate = replay.tick_rate();
+		gravity = replay.gravity();
+	}
+	if (record_path != nullptr && !recorder.open(record_path, seed, tick_rate, gravity)) {
+		std::fprintf(stderr, "cannot write %s\n", record_path);
+		return 1;
+	}
+
 	// init
-	SetTraceLogLevel(LOG_ALL);
+	start_log_thread(stdout);
+	// raylib writes its own log to stdout as it goes, on the render thread. Only
+	// its warnings and errors are worth that.
+	SetTraceLogLevel(LOG_WARNING);
 	InitWindow(WINDOW_WIDTH, WINDOW_HEIGHT, "Tetris!");
 	SetTargetFPS(FPS_TARGET);
 	load_block_texture();
+	layer.target = LoadRenderTexture(WINDOW_WIDTH, WINDOW_HEIGHT);
 
-	game();
+	game(seed);
+	recorder.close();
+	replaying = false;
 
+	// the game over screen only changes on input, no need to draw it 60 times a
+	// second
+	std::array<char, 32> score_text{};
+	EnableEventWaiting();
 	while (!WindowShouldClose()) {
 		if (IsKeyPressed(KEY_R)) {
-			if (game()) {
-				return 0;
+			DisableEventWaiting();
+			if (game(rd())) {
+				break;
 			} else {
-				TraceLog(LOG_INFO, "Restarted!");
+				log_info("Restarted!");
 			}
+			EnableEventWaiting();
 		}
 		BeginDrawing();
 
-		std::string score_str = std::format("score: {}", score);
-		size_t loss_length = std::max(score_str.length(), static_cast<size_t>(11));
+		const char *score_str = format_text(score_text, "score: {}", score);
+		size_t loss_length = std::max(std::strlen(score_str), static_cast<size_t>(11));
 		size_t loss_width = (loss_length * 14);
 
 		int text_x = static_cast<int>((WINDOW_WIDTH / 2) - (loss_width / 2));
@@ -241,13 +555,18 @@ int main() {
 			ColorAlpha(DARKGRAY, 0.3F)
 		);
 		DrawText("YOU LOSE.", text_x, text_y, 24, WHITE);
-		DrawText(score_str.c_str(), text_x, text_y + 48, 24, WHITE);
+		DrawText(score_str, text_x, text_y + 48, 24, WHITE);
 		EndDrawing();
 	}
 
 	// close
+	if (trace_path != nullptr && !write_chrome_trace(trace_path)) {
+		log_warning("cannot write the profile to {}", trace_path);
+	}
+	UnloadRenderTexture(layer.target);
 	unload_block_texture();
 	CloseWindow();
+	stop_log_thread();
 
 	return 0;
 }
@@ -0,0 +1,229 @@
+#include "collision.hpp"
+#include "movegen.hpp"
+
+// The search works on whole columns of states at once. For every orientation and
+// pattern column offset, a 64 bit mask holds one bit per pattern row offset,
+// bit `y - MOVEGEN_MIN_Y`. Moving down is a shift, moving sideways or rotating
+// moves bits to another mask, and a flood fill repeats that until nothing new is
+// reached.
+typedef uint64_t StateMask;
+typedef std::array<std::array<StateMask, MOVEGEN_COLUMNS>, 4> StateMasks;
+
+static_assert(MOVEGEN_ROWS + 5 <= 64, "state rows and the floor must fit a mask");
+const StateMask ROWS_MASK = (StateMask{1} << MOVEGEN_ROWS) - 1;
+
+static StateMask shift_rows(StateMask mask, int dy) {
+	return dy >= 0 ? mask << dy : mask >> -dy;
+}
+
+// States reachable from `reached` by moving down through `free` states.
+static StateMask fill_down(StateMask reached, StateMask free) {
+	// Kogge-Stone fill, doubling the distance covered each step
+	StateMask open = free;
+	reached |= open & (reached << 1);
+	open &= open << 1;
+	reached |= open & (reached << 2);
+	open &= open << 2;
+	reached |= open & (reached << 4);
+	open &= open << 4;
+	reached |= open & (reached << 8);
+	open &= open << 8;
+	reached |= open & (reached << 16);
+	open &= open << 16;
+	reached |= open & (reached << 32);
+	return reached;
+}
+
+// Bit `y - MOVEGEN_MIN_Y` of `obstructed[idx][x - MOVEGEN_MIN_X]` is set when the
+// piece would be obstructed there, same as `piece_obstructed`.
+static void obstruction_masks(const Board &board, PieceType type, StateMasks &obstructed) {
+	// board columns, rows below the floor count as occupied
+	std::array<StateMask, GRID_WIDTH> columns{};
+	StateMask floor = ~StateMask{0} << (GRID_HEIGHT - MOVEGEN_MIN_Y);
+	for (size_t x = 0; x < GRID_WIDTH; ++x) {
+		columns[x] = floor;
+	}
+	for (int y = 0; y < GRID_HEIGHT; ++y) {
+		Row row = board.row(y);
+		for (size_t x = 0; row != 0; ++x, row >>= 1) {
+			if (row & 1U) {
+				columns[x] |= StateMask{1} << (y - MOVEGEN_MIN_Y);
+			}
+		}
+	}
+
+	const PieceDef &def = PIECES[type];
+	for (size_t idx = 0; idx < 4; ++idx) {
+		for (size_t column = 0; column < MOVEGEN_COLUMNS; ++column) {
+			int x = static_cast<int>(column) + MOVEGEN_MIN_X;
+			StateMask mask = 0;
+			for (const auto &cell : def.cells[idx]) {
+				int cell_x = x + cell.x;
+				if (cell_x < 0 || cell_x >= GRID_WIDTH) {
+					mask = ~StateMask{0};
+					break;
+				}
+				mask |= columns[static_cast<size_t>(cell_x)] >> cell.y;
+			}
+			obstructed[idx][column] = mask;
+		}
+	}
+}
+
+// Closes the states of one orientation under moving down, left and right. Sweeps
+// right then left, each carrying states along in its own direction in one pass;
+// a pass only repeats when a state found on the way back can move the other way.
+static void spread(
+	std::array<StateMask, MOVEGEN_COLUMNS> &reached,
+	const std::array<StateMask, MOVEGEN_COLUMNS> &free
+) {
+	const size_t last = MOVEGEN_COLUMNS - 1;
+	for (bool changed = true; changed;) {
+		changed = false;
+		for (size_t column = 0; column <= last; ++column) {
+			if (reached[column] == 0) {
+				continue;
+			}
+			reached[column] = fill_down(reached[column], free[column]);
+			if (column < last) {
+				reached[column + 1] |= reached[column] & free[column + 1];
+			}
+			if (column > 0) {
+				StateMask left = reached[column] & free[column - 1];
+				changed |= (left & ~reached[column - 1]) != 0;
+				reached[column - 1] |= left;
+			}
+		}
+		if (!changed) {
+			break;
+		}
+		changed = false;
+		for (size_t column = last + 1; column-- > 0;) {
+			if (reached[column] == 0) {
+				continue;
+			}
+			reached[column] = fill_down(reached[column], free[column]);
+			if (column > 0) {
+				reached[column - 1] |= reached[column] & free[column - 1];
+			}
+			if (column < last) {
+				StateMask right = reached[column] & free[column + 1];
+				changed |= (right & ~reached[column + 1]) != 0;
+				reached[column + 1] |= right;
+			}
+		}
+	}
+}
+
+// Moves every state of `from` that the kick tests let turn into orientation `to`.
+static bool rotate_states(
+	StateMask from, const std::array<Coordinate, 5> &tests, size_t column,
+	const std::array<StateMask, MOVEGEN_COLUMNS> &free_to,
+	std::array<StateMask, MOVEGEN_COLUMNS> &reached_to
+) {
+	bool changed = false;
+	// states stay here until a test fits, later tests only see what is left
+	StateMask remaining = from;
+	for (const auto &test : tests) {
+		if (remaining == 0) {
+			break;
+		}
+		int to_column = static_cast<int>(column) + test.x;
+		if (to_column < 0 || to_column >= static_cast<int>(MOVEGEN_COLUMNS)) {
+			continue; // past the searched range, the wall obstructs it
+		}
+		auto c = static_cast<size_t>(to_column);
+		StateMask fits = remaining & shift_rows(free_to[c], -test.y);
+		remaining &= ~fits;
+		StateMask landed = shift_rows(fits, test.y) & ROWS_MASK;
+		if (landed & ~reached_to[c]) {
+			reached_to[c] |= landed;
+			changed = true;
+		}
+	}
+	return changed;
+}
+
+void generate_placements(const Board &board, PieceType type, PlacementList &out) {
+	out.count = 0;
+	if (piece_obstructed(board, type, 0, SPAWN_X, SPAWN_Y)) {
+		return;
+	}
+
+	StateMasks obstructed;
+	obstruction_masks(board, type, obstructed);
+	StateMasks free;
+	for (size_t idx = 0; idx < 4; ++idx) {
+		for (size_t column = 0; column < MOVEGEN_COLUMNS; ++column) {
+			free[idx][column] = ~obstructed[idx][column] & ROWS_MASK;
+		}
+	}
+
+	StateMasks reached{};
+	reached[0][SPAWN_X - MOVEGEN_MIN_X] = StateMask{1} << (SPAWN_Y - MOVEGEN_MIN_Y);
+	// states already turned, each state only needs its kick tests run once
+	StateMasks rotated{};
+	std::array<bool, 4> dirty = {true, false, false, false};
+
+	const PieceDef &def = PIECES[type];
+	for (bool changed = true; changed;) {
+		changed = false;
+		for (size_t idx = 0; idx < 4; ++idx) {
+			if (!dirty[idx]) {
+				continue;
+			}
+			dirty[idx] = false;
+			spread(reached[idx], free[idx]);
+
+			size_t cw = idx >= 3 ? 0 : idx + 1;
+			size_t ccw = idx <= 0 ? 3 : idx - 1;
+			for (size_t column = 0; column < MOVEGEN_COLUMNS; ++column) {
+				StateMask states = reached[idx][column] & ~rotated[idx][column];
+				if (states == 0) {
+					continue;
+				}
+				rotated[idx][column] |= states;
+				if (rotate_states(states, def.cw_kicks[idx], column, free[cw], reached[cw])) {
+					dirty[cw] = true;
+					changed = true;
+				}
+				if (rotate_states(
+						states, def.ccw_kicks[idx], column, free[ccw], reached[ccw]
+					)) {
+					dirty[ccw] = true;
+					changed = true;
+				}
+			}
+		}
+	}
+
+	// a state is at rest when moving down is obstructed
+	for (size_t idx = 0; idx < 4; ++idx) {
+		for (size_t column = 0; column < MOVEGEN_COLUMNS; ++column) {
+			StateMask resting = reached[idx][column] & (obstructed[idx][column] >> 1);
+			while (resting != 0) {
+				int row = __builtin_ctzll(resting);
+				resting &= resting - 1;
+				out.items[out.count++] = Placement{
+					.type = type,
+					.idx = static_cast<uint8_t>(idx),
+					.x = static_cast<int8_t>(static_cast<int>(column) + MOVEGEN_MIN_X),
+					.y = static_cast<int8_t>(row + MOVEGEN_MIN_Y),
+				};
+			}
+		}
+	}
+}
+
+std::array<Block, 4> placement_blocks(const Placement &placement) {
+	const PieceDef &def = PIECES[placement.type];
+	std::array<Block, 4> blocks{};
+	for (size_t i = 0; i < 4; ++i) {
+		Coordinate cell = def.cells[placement.idx][i];
+		blocks[i] = Block{
+			.pos = {.x = cell.x + placement.x, .y = cell.y + placement.y},
+			.color = def.color,
+		};
+	}
+	return blocks;
+}
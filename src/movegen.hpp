@@ -0,0 +1,43 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "board.hpp"
+#include "pieces.hpp"
+
+// A piece at rest, as the orientation and offset of its pattern
+struct Placement {
+	PieceType type;
+	uint8_t idx; // orientation, index into the piece patterns
+	int8_t x;	 // pattern offset, same as `Tetramino::get_x_offset`
+	int8_t y;	 // pattern offset, same as `Tetramino::get_y_offset`
+};
+
+// Range of pattern offsets searched. A 5x5 pattern can hang up to 4 columns past
+// either wall, and pieces spawn and kick above the board. Anything further up is
+// not searched.
+const int MOVEGEN_MIN_X = -4;
+const int MOVEGEN_MIN_Y = -8;
+const size_t MOVEGEN_COLUMNS = GRID_WIDTH + 4;
+const size_t MOVEGEN_ROWS = GRID_HEIGHT + 8;
+const size_t MAX_PLACEMENTS = 4 * MOVEGEN_COLUMNS * MOVEGEN_ROWS;
+
+struct PlacementList {
+	std::array<Placement, MAX_PLACEMENTS> items;
+	size_t count = 0;
+
+	const Placement *begin() const { return items.data(); }
+	const Placement *end() const { return items.data() + count; }
+};
+
+// Fills `out` with every distinct resting placement `type` can reach from spawn on
+// `board`, by moving left, right and down and by rotating either way with the kick
+// tests of `PIECES`, so tucks and spins under overhangs are included. Placements
+// are distinct by orientation and offset. `out` is left empty when the spawn
+// position is already obstructed.
+void generate_placements(const Board &board, PieceType type, PlacementList &out);
+
+// The blocks of `placement` on the board
+std::array<Block, 4> placement_blocks(const Placement &placement);
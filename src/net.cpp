@@ -0,0 +1,87 @@
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "net.hpp"
+
+// Fills `addr` for `at`, returns its length or 0 when the Unix path is too long.
+static socklen_t make_address(const Endpoint &at, sockaddr_storage &addr) {
+	std::memset(&addr, 0, sizeof(addr));
+	if (!at.unix_path.empty()) {
+		auto *un = reinterpret_cast<sockaddr_un *>(&addr);
+		if (at.unix_path.size() >= sizeof(un->sun_path)) {
+			return 0;
+		}
+		un->sun_family = AF_UNIX;
+		std::memcpy(un->sun_path, at.unix_path.c_str(), at.unix_path.size() + 1);
+		return sizeof(sockaddr_un);
+	}
+	auto *in = reinterpret_cast<sockaddr_in *>(&addr);
+	in->sin_family = AF_INET;
+	in->sin_port = htons(at.port);
+	in->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	return sizeof(sockaddr_in);
+}
+
+int listen_on(const Endpoint &at) {
+	sockaddr_storage addr{};
+	socklen_t len = make_address(at, addr);
+	if (len == 0) {
+		errno = ENAMETOOLONG;
+		return -1;
+	}
+	int fd = socket(addr.ss_family, SOCK_STREAM, 0);
+	if (fd < 0) {
+		return -1;
+	}
+	if (at.unix_path.empty()) {
+		int on = 1;
+		setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+	} else {
+		unlink(at.unix_path.c_str());
+	}
+	if (bind(fd, reinterpret_cast<sockaddr *>(&addr), len) != 0 ||
+		listen(fd, SOMAXCONN) != 0 || !set_nonblocking(fd)) {
+		int err = errno;
+		close(fd);
+		errno = err;
+		return -1;
+	}
+	return fd;
+}
+
+int connect_to(const Endpoint &at) {
+	sockaddr_storage addr{};
+	socklen_t len = make_address(at, addr);
+	if (len == 0) {
+		errno = ENAMETOOLONG;
+		return -1;
+	}
+	int fd = socket(addr.ss_family, SOCK_STREAM, 0);
+	if (fd < 0) {
+		return -1;
+	}
+	if (connect(fd, reinterpret_cast<sockaddr *>(&addr), len) != 0) {
+		int err = errno;
+		close(fd);
+		errno = err;
+		return -1;
+	}
+	return fd;
+}
+
+bool set_nonblocking(int fd) {
+	int flags = fcntl(fd, F_GETFL, 0);
+	return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+void set_nodelay(int fd) {
+	int on = 1;
+	setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Where tetris_server listens: a TCP port on the loopback address, or a Unix socket
+// when `unix_path` is set.
+struct Endpoint {
+	uint16_t port = 7878;
+	std::string unix_path;
+};
+
+// A non-blocking socket listening on `at`, -1 on failure with errno set. A stale
+// Unix socket file from an earlier run is replaced.
+int listen_on(const Endpoint &at);
+// A blocking socket connected to `at`, -1 on failure with errno set.
+int connect_to(const Endpoint &at);
+bool set_nonblocking(int fd);
+// Sends small writes right away, for TCP sockets. Does nothing for Unix sockets.
+void set_nodelay(int fd);
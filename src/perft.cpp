@@ -0,0 +1,103 @@
+// Counts move generator placements, the way chess perft counts moves.
+//
+// usage: tetris_perft <depth> [sequence]
+//
+// `sequence` is a string of piece letters (IJLTOSZ), one per depth, repeated when
+// it is shorter than the depth. For every depth up to `depth`, prints the number
+// of distinct placement sequences reachable from an empty board, and how fast
+// they were generated.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "board.hpp"
+#include "movegen.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+struct Perft {
+	std::vector<PieceType> sequence;
+	// one list per depth, so recursion does not need its own
+	std::vector<PlacementList> lists;
+	uint64_t generated = 0;
+
+	uint64_t count(const Board &board, size_t ply, size_t depth) {
+		PlacementList &list = lists[ply];
+		generate_placements(board, sequence[ply % sequence.size()], list);
+		generated += list.count;
+		if (ply + 1 == depth) {
+			return list.count;
+		}
+
+		uint64_t nodes = 0;
+		for (const auto &placement : list) {
+			auto blocks = placement_blocks(placement);
+			// a piece locked above the board ends the game
+			bool lost = false;
+			for (const auto &b : blocks) {
+				lost |= b.pos.y < 0;
+			}
+			if (lost) {
+				continue;
+			}
+
+			Board next = board;
+			next.place(blocks);
+			clear_blocks(next, blocks);
+			nodes += count(next, ply + 1, depth);
+		}
+		return nodes;
+	}
+};
+
+static bool parse_sequence(const char *text, std::vector<PieceType> &out) {
+	const std::string letters = "IJLTOSZ";
+	for (const char *c = text; *c != '\0'; ++c) {
+		auto i = letters.find(*c);
+		if (i == std::string::npos) {
+			return false;
+		}
+		out.push_back(static_cast<PieceType>(i));
+	}
+	return !out.empty();
+}
+
+int main(int argc, char **argv) {
+	if (argc < 2) {
+		std::fprintf(stderr, "usage: %s <depth> [sequence]\n", argv[0]);
+		return 1;
+	}
+	int depth = std::atoi(argv[1]);
+	if (depth < 1) {
+		std::fprintf(stderr, "depth must be at least 1\n");
+		return 1;
+	}
+
+	Perft perft{};
+	if (!parse_sequence(argc > 2 ? argv[2] : "IJLTOSZ", perft.sequence)) {
+		std::fprintf(stderr, "sequence must be made of the letters IJLTOSZ\n");
+		return 1;
+	}
+	perft.lists.resize(static_cast<size_t>(depth));
+
+	const Board empty{};
+	for (size_t d = 1; d <= static_cast<size_t>(depth); ++d) {
+		perft.generated = 0;
+		auto start = Clock::now();
+		uint64_t nodes = perft.count(empty, 0, d);
+		double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+		std::printf(
+			"depth %zu: %llu nodes, %llu placements generated in %.3fs (%.0f/s)\n",
+			d,
+			static_cast<unsigned long long>(nodes),
+			static_cast<unsigned long long>(perft.generated),
+			seconds,
+			static_cast<double>(perft.generated) / seconds
+		);
+	}
+	return 0;
+}
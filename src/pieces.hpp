@@ -0,0 +1,396 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "block.hpp"
+
+using std::array;
+
+struct RotationOffsets {
+	// clang-format off
+	array<Coordinate,5> ZERO =  {{{0, 0}, {0, 0},  {0, 0},   {0, 0},  {0, 0}}};
+	array<Coordinate,5> RIGHT = {{{0, 0}, {1, 0},  {1, -1},  {0, 2},  {1, 2}}};
+	array<Coordinate,5> TWO =   {{{0, 0}, {0, 0},  {0, 0},   {0, 0},  {0, 0}}};
+	array<Coordinate,5> LEFT =  {{{0, 0}, {-1, 0}, {-1, -1}, {0, 2},  {-1, 2}}};
+	// clang-format on
+	constexpr array<Coordinate, 5> get_rotation_offset(size_t i) const {
+		switch (i) {
+		case 0:
+			return ZERO;
+		case 1:
+			return LEFT;
+		case 2:
+			return TWO;
+		case 3:
+			return RIGHT;
+		};
+		return ZERO;
+	}
+};
+
+typedef array<array<bool, 5>, 5> Pattern;
+
+enum PieceType : uint8_t {
+	PIECE_I = 0,
+	PIECE_J,
+	PIECE_L,
+	PIECE_T,
+	PIECE_O,
+	PIECE_S,
+	PIECE_Z,
+};
+const size_t PIECE_COUNT = 7;
+
+// Pattern offset of a newly spawned piece
+const int SPAWN_X = 3;
+const int SPAWN_Y = -3;
+
+// Cell coordinates of one orientation, relative to the piece offset
+typedef array<Coordinate, 4> Cells;
+// Translations to try, in order, when rotating out of each orientation. The
+// first is always {0, 0}, the plain rotation.
+typedef array<array<Coordinate, 5>, 4> Kicks;
+
+// Everything needed to build and rotate a piece, generated at compile time from
+// its patterns so that spawning and rotating never scan a `Pattern`.
+struct PieceDef {
+	BlockColor color;
+	array<Cells, 4> cells;
+	// One mask per pattern row and orientation, bit `x` set for pattern column `x`
+	array<array<uint8_t, 5>, 4> masks;
+	// Per orientation, the pattern rows and columns the blocks span
+	array<Coordinate, 4> min_cell;
+	array<Coordinate, 4> max_cell;
+	Kicks cw_kicks;
+	Kicks ccw_kicks;
+};
+
+// `ptn` must contain exactly 4 ones, otherwise the table fails to compile.
+constexpr Cells pattern_cells(const Pattern &ptn) {
+	Cells cells{};
+	size_t count = 0;
+	for (size_t x = 0; x < 5; ++x) {
+		for (size_t y = 0; y < 5; ++y) {
+			if (!ptn[y][x]) {
+				continue;
+			}
+			if (count > 3) {
+				throw "pattern has more than 4 blocks";
+			}
+			cells[count++] = {.x = static_cast<int>(x), .y = static_cast<int>(y)};
+		}
+	}
+	if (count != 4) {
+		throw "pattern has less than 4 blocks";
+	}
+	return cells;
+}
+
+constexpr array<uint8_t, 5> pattern_masks(const Pattern &ptn) {
+	array<uint8_t, 5> masks{};
+	for (size_t y = 0; y < 5; ++y) {
+		for (size_t x = 0; x < 5; ++x) {
+			if (ptn[y][x]) {
+				masks[y] = static_cast<uint8_t>(masks[y] | (1U << x));
+			}
+		}
+	}
+	return masks;
+}
+
+// Each failed kick test moves the piece on by `o2[i] - o1[i]`, so the translation
+// of test `i` is the running sum of the differences before it.
+constexpr array<Coordinate, 5>
+kick_tests(const array<Coordinate, 5> &o1, const array<Coordinate, 5> &o2) {
+	array<Coordinate, 5> tests{};
+	for (size_t i = 1; i < 5; ++i) {
+		tests[i] = {
+			.x = tests[i - 1].x + o2[i - 1].x - o1[i - 1].x,
+			.y = tests[i - 1].y + o2[i - 1].y - o1[i - 1].y,
+		};
+	}
+	return tests;
+}
+
+constexpr PieceDef
+make_piece(BlockColor color, const array<Pattern, 4> &pattern, RotationOffsets offsets) {
+	PieceDef def{
+		.color = color,
+		.cells = {},
+		.masks = {},
+		.min_cell = {},
+		.max_cell = {},
+		.cw_kicks = {},
+		.ccw_kicks = {},
+	};
+	for (size_t i = 0; i < 4; ++i) {
+		def.cells[i] = pattern_cells(pattern[i]);
+		def.masks[i] = pattern_masks(pattern[i]);
+		def.min_cell[i] = def.cells[i][0];
+		def.max_cell[i] = def.cells[i][0];
+		for (const auto &cell : def.cells[i]) {
+			def.min_cell[i].x = cell.x < def.min_cell[i].x ? cell.x : def.min_cell[i].x;
+			def.min_cell[i].y = cell.y < def.min_cell[i].y ? cell.y : def.min_cell[i].y;
+			def.max_cell[i].x = cell.x > def.max_cell[i].x ? cell.x : def.max_cell[i].x;
+			def.max_cell[i].y = cell.y > def.max_cell[i].y ? cell.y : def.max_cell[i].y;
+		}
+
+		size_t cw = i >= 3 ? 0 : i + 1;
+		def.cw_kicks[i] = kick_tests(
+			offsets.get_rotation_offset(cw >= 3 ? 0 : cw + 1),
+			offsets.get_rotation_offset(cw)
+		);
+
+		size_t ccw = i <= 0 ? 3 : i - 1;
+		def.ccw_kicks[i] = kick_tests(
+			offsets.get_rotation_offset(ccw),
+			offsets.get_rotation_offset(ccw <= 0 ? 3 : ccw - 1)
+		);
+	}
+	return def;
+}
+
+constexpr array<Pattern, 4> I_PATTERN = {{
+	{{
+		{{0, 0, 0, 0, 0}},
+		{{0, 0, 0, 0, 0}},
+		{{0, 1, 1, 1, 1}},
+		{{0, 0, 0, 0, 0}},
+		{{0, 0, 0, 0, 0}},
+	}},
+	{{
+		{{0, 0, 0, 0, 0}},
+		{{0, 0, 1, 0, 0}},
+		{{0, 0, 1, 0, 0}},
+		{{0, 0, 1, 0, 0}},
+		{{0, 0, 1, 0, 0}},
+	}},
+	{{
+		{{0, 0, 0, 0, 0}},
+		{{0, 0, 0, 0, 0}},
+		{{1, 1, 1, 1, 0}},
+		{{0, 0, 0, 0, 0}},
+		{{0, 0, 0, 0, 0}},
+	}},
+	{{
+		{{0, 0, 1, 0, 0}},
+		{{0, 0, 1, 0, 0}},
+		{{0, 0, 1, 0, 0}},
+		{{0, 0, 1, 0, 0}},
+		{{0, 0, 0, 0, 0}},
+	}},
+}};
+
+constexpr array<Pattern, 4> J_PATTERN = {{
+	{{
+		{{0, 0, 0, 0, 0}},
+		{{0, 1, 0, 0, 0}},
+		{{0, 1, 1, 1, 0}},
+		{{0, 0, 0, 0, 0}},
+		{{0, 0, 0, 0, 0}},
+	}},
+	{{
+		{{0, 0, 0, 0, 0}},
+		{{0, 0, 1, 1, 0}},
+		{{0, 0, 1, 0, 0}},
+		{{0, 0, 1, 0, 0}},
+		{{0, 0, 0, 0, 0}},
+	}},
+	{{
+		{{0, 0, 0, 0, 0}},
+		{{0, 0, 0, 0, 0}},
+		{{0, 1, 1, 1, 0}},
+		{{0, 0, 0, 1, 0}},
+		{{0, 0, 0, 0, 0}},
+	}},
+	{{
+		{{0, 0, 0, 0, 0}},
+		{{0, 0, 1, 0, 0}},
+		{{0, 0, 1, 0, 0}},
+		{{0, 1, 1, 0, 0}},
+		{{0, 0, 0, 0, 0}},
+	}},
+}};
+
+constexpr array<Pattern, 4> L_PATTERN = {{
+	{{
+		{{0, 0, 0, 0, 0}},
+		{{0, 0, 0, 1, 0}},
+		{{0, 1, 1, 1, 0}},
+		{{0, 0, 0, 0, 0}},
+		{{0, 0, 0, 0, 0}},
+	}},
+	{{
+		{{0, 0, 0, 0, 0}},
+		{{0, 0, 1, 0, 0}},
+		{{0, 0, 1, 0, 0}},
+		{{0, 0, 1, 1, 0}},
+		{{0, 0, 0, 0, 0}},
+	}},
+	{{
+		{{0, 0, 0, 0, 0}},
+		{{0, 0, 0, 0, 0}},
+		{{0, 1, 1, 1, 0}},
+		{{0, 1, 0, 0, 0}},
+		{{0, 0, 0, 0, 0}},
+	}},
+	{{
+		{{0, 0, 0, 0, 0}},
+		{{0, 1, 1, 0, 0}},
+		{{0, 0, 1, 0, 0}},
+		{{0, 0, 1, 0, 0}},
+		{{0, 0, 0, 0, 0}},
+	}},
+}};
+
+constexpr array<Pattern, 4> T_PATTERN = {{
+	{{
+		{{0, 0, 0, 0, 0}},
+		{{0, 0, 1, 0, 0}},
+		{{0, 1, 1, 1, 0}},
+		{{0, 0, 0, 0, 0}},
+		{{0, 0, 0, 0, 0}},
+	}},
+	{{
+		{{0, 0, 0, 0, 0}},
+		{{0, 0, 1, 0, 0}},
+		{{0, 0, 1, 1, 0}},
+		{{0, 0, 1, 0, 0}},
+		{{0, 0, 0, 0, 0}},
+	}},
+	{{
+		{{0, 0, 0, 0, 0}},
+		{{0, 0, 0, 0, 0}},
+		{{0, 1, 1, 1, 0}},
+		{{0, 0, 1, 0, 0}},
+		{{0, 0, 0, 0, 0}},
+	}},
+	{{
+		{{0, 0, 0, 0, 0}},
+		{{0, 0, 1, 0, 0}},
+		{{0, 1, 1, 0, 0}},
+		{{0, 0, 1, 0, 0}},
+		{{0, 0, 0, 0, 0}},
+	}},
+}};
+
+constexpr array<Pattern, 4> O_PATTERN = {{
+	{{
+		{{0, 0, 0, 0, 0}},
+		{{0, 0, 1, 1, 0}},
+		{{0, 0, 1, 1, 0}},
+		{{0, 0, 0, 0, 0}},
+		{{0, 0, 0, 0, 0}},
+	}},
+	{{
+		{{0, 0, 0, 0, 0}},
+		{{0, 0, 0, 0, 0}},
+		{{0, 0, 1, 1, 0}},
+		{{0, 0, 1, 1, 0}},
+		{{0, 0, 0, 0, 0}},
+	}},
+	{{
+		{{0, 0, 0, 0, 0}},
+		{{0, 0, 0, 0, 0}},
+		{{0, 1, 1, 0, 0}},
+		{{0, 1, 1, 0, 0}},
+		{{0, 0, 0, 0, 0}},
+	}},
+	{{
+		{{0, 0, 0, 0, 0}},
+		{{0, 1, 1, 0, 0}},
+		{{0, 1, 1, 0, 0}},
+		{{0, 0, 0, 0, 0}},
+		{{0, 0, 0, 0, 0}},
+	}},
+}};
+
+constexpr array<Pattern, 4> S_PATTERN = {{
+	{{
+		{{0, 0, 0, 0, 0}},
+		{{0, 0, 1, 1, 0}},
+		{{0, 1, 1, 0, 0}},
+		{{0, 0, 0, 0, 0}},
+		{{0, 0, 0, 0, 0}},
+	}},
+	{{
+		{{0, 0, 0, 0, 0}},
+		{{0, 0, 1, 0, 0}},
+		{{0, 0, 1, 1, 0}},
+		{{0, 0, 0, 1, 0}},
+		{{0, 0, 0, 0, 0}},
+	}},
+	{{
+		{{0, 0, 0, 0, 0}},
+		{{0, 0, 0, 0, 0}},
+		{{0, 0, 1, 1, 0}},
+		{{0, 1, 1, 0, 0}},
+		{{0, 0, 0, 0, 0}},
+	}},
+	{{
+		{{0, 0, 0, 0, 0}},
+		{{0, 1, 0, 0, 0}},
+		{{0, 1, 1, 0, 0}},
+		{{0, 0, 1, 0, 0}},
+		{{0, 0, 0, 0, 0}},
+	}},
+}};
+
+constexpr array<Pattern, 4> Z_PATTERN = {{
+	{{
+		{{0, 0, 0, 0, 0}},
+		{{0, 1, 1, 0, 0}},
+		{{0, 0, 1, 1, 0}},
+		{{0, 0, 0, 0, 0}},
+		{{0, 0, 0, 0, 0}},
+	}},
+	{{
+		{{0, 0, 0, 0, 0}},
+		{{0, 0, 0, 1, 0}},
+		{{0, 0, 1, 1, 0}},
+		{{0, 0, 1, 0, 0}},
+		{{0, 0, 0, 0, 0}},
+	}},
+	{{
+		{{0, 0, 0, 0, 0}},
+		{{0, 0, 0, 0, 0}},
+		{{0, 1, 1, 0, 0}},
+		{{0, 0, 1, 1, 0}},
+		{{0, 0, 0, 0, 0}},
+	}},
+	{{
+		{{0, 0, 0, 0, 0}},
+		{{0, 0, 1, 0, 0}},
+		{{0, 1, 1, 0, 0}},
+		{{0, 1, 0, 0, 0}},
+		{{0, 0, 0, 0, 0}},
+	}},
+}};
+
+// clang-format off
+constexpr RotationOffsets I_OFFSETS {
+	.ZERO =  {{{0, 0},  {-1, 0}, {2, 0},  {-1, 0}, {2, 0}}},
+	.RIGHT = {{{-1, 0}, {0, 0},  {0, 0},  {0, 1},  {0, -2}}},
+	.TWO =   {{{-1, 1}, {1, 1},  {-2, 1}, {1, 0},  {-2, 0}}},
+	.LEFT =  {{{0, 1},  {0, 1},  {0, 1},  {0, -1}, {0, 2}}},
+};
+constexpr RotationOffsets O_OFFSETS{
+	.ZERO =  {{{0, 0},   {0, 0},   {0, 0},   {0, 0},   {0, 0}}},
+	.RIGHT = {{{0, -1},  {0, -1},  {0, -1},  {0, -1},  {0, -1}}},
+	.TWO =   {{{-1, -1}, {-1, -1}, {-1, -1}, {-1, -1}, {-1, -1}}},
+	.LEFT =  {{{-1, 0},  {-1, 0},  {-1, 0},  {-1, 0},  {-1, 0}}},
+};
+// clang-format on
+
+// Indexed by `PieceType`
+constexpr array<PieceDef, PIECE_COUNT> PIECES = {
+	make_piece(COLOR_I, I_PATTERN, I_OFFSETS),
+	make_piece(COLOR_J, J_PATTERN, {}),
+	make_piece(COLOR_L, L_PATTERN, {}),
+	make_piece(COLOR_T, T_PATTERN, {}),
+	make_piece(COLOR_O, O_PATTERN, O_OFFSETS),
+	make_piece(COLOR_S, S_PATTERN, {}),
+	make_piece(COLOR_Z, Z_PATTERN, {}),
+};
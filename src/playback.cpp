@@ -0,0 +1,121 @@
+// Plays a replay recorded with `tetris --record` back without a window.
+//
+// usage: tetris_playback <replay> [-r] [-n times]
+//
+// By default the replay runs as fast as it can, `times` times over, and reports
+// the step rate, which makes a captured session a benchmark of the game rules.
+// With -r it runs once at the tick rate it was recorded at. Either way every
+// recorded state hash is checked, and the first step where the game no longer
+// matches the recording is reported.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#include "game.hpp"
+#include "replay.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+struct PlaybackResult {
+	uint64_t steps = 0;
+	uint score = 0;
+	bool over = false;
+	bool desynced = false;
+	uint64_t desync_step = 0;
+};
+
+static PlaybackResult play(ReplayReader replay, bool realtime) {
+	Game game{replay.seed(), replay.tick_rate(), replay.gravity()};
+	PlaybackResult res{};
+	const auto step_time = std::chrono::duration_cast<Clock::duration>(
+		std::chrono::duration<double>(1.0 / replay.tick_rate())
+	);
+	auto next_step = Clock::now();
+
+	ReplayStep step{};
+	while (replay.next(step)) {
+		if (realtime) {
+			next_step += step_time;
+			std::this_thread::sleep_until(next_step);
+		}
+		game.step(step.inputs);
+		++res.steps;
+		if (step.check && !res.desynced && state_hash(game.state()) != step.hash) {
+			res.desynced = true;
+			res.desync_step = res.steps - 1;
+		}
+	}
+	res.score = game.state().score;
+	res.over = game.state().over;
+	return res;
+}
+
+int main(int argc, char **argv) {
+	const char *path = nullptr;
+	bool realtime = false;
+	int times = 1;
+	for (int i = 1; i < argc; ++i) {
+		if (std::strcmp(argv[i], "-r") == 0) {
+			realtime = true;
+		} else if (std::strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+			times = std::atoi(argv[++i]);
+		} else {
+			path = argv[i];
+		}
+	}
+	if (path == nullptr || times < 1) {
+		std::fprintf(stderr, "usage: %s <replay> [-r] [-n times]\n", argv[0]);
+		return 1;
+	}
+
+	ReplayReader replay{};
+	if (!replay.load(path)) {
+		std::fprintf(stderr, "%s: not a replay of version %d\n", path, REPLAY_VERSION);
+		return 1;
+	}
+	if (realtime) {
+		times = 1;
+	}
+
+	PlaybackResult res{};
+	auto start = Clock::now();
+	for (int i = 0; i < times; ++i) {
+		res = play(replay, realtime);
+	}
+	double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+	std::printf(
+		"seed %u, %d steps/s, %llu steps, score %u, %s\n",
+		replay.seed(),
+		replay.tick_rate(),
+		static_cast<unsigned long long>(res.steps),
+		res.score,
+		res.over ? "game over" : "stopped while playing"
+	);
+	std::printf(
+		"played %d time(s) in %.3fs (%.0f steps/s)\n",
+		times,
+		seconds,
+		static_cast<double>(res.steps) * times / seconds
+	);
+
+	// `play` works on a copy, see whether the file itself ended early
+	ReplayStep step{};
+	while (replay.next(step)) {
+	}
+	if (replay.truncated()) {
+		std::printf("warning: the replay is damaged or cut off, played up to there\n");
+	}
+	if (res.desynced) {
+		std::printf(
+			"DESYNC: state differs from the recording at step %llu\n",
+			static_cast<unsigned long long>(res.desync_step)
+		);
+		return 2;
+	}
+	return 0;
+}
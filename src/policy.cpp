@@ -0,0 +1,155 @@
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+
+#include "policy.hpp"
+
+size_t RandomPolicy::choose(const GameState & /*state*/, const PlacementList &placements) {
+	std::uniform_int_distribution<size_t> pick(0, placements.count - 1);
+	return pick(rng);
+}
+
+// Set bits of `bits`. `std::popcount` is a library call without a popcnt target,
+// this stays inline everywhere.
+static int count_bits(uint64_t bits) {
+	bits -= (bits >> 1) & 0x5555555555555555;
+	bits = (bits & 0x3333333333333333) + ((bits >> 2) & 0x3333333333333333);
+	bits = (bits + (bits >> 4)) & 0x0f0f0f0f0f0f0f0f;
+	return static_cast<int>((bits * 0x0101010101010101) >> 56);
+}
+
+int count_holes(const Board &board) {
+	// the hole masks are packed four rows to a word and counted together
+	int holes = 0;
+	uint64_t hole_bits = 0;
+	Row covered = 0;
+	for (int y = 0; y < GRID_HEIGHT; ++y) {
+		Row row = board.row(y);
+		hole_bits |= static_cast<uint64_t>(covered & ~row) << (16 * (y % 4));
+		if (y % 4 == 3) {
+			holes += count_bits(hole_bits);
+			hole_bits = 0;
+		}
+		covered |= row;
+	}
+	return holes + count_bits(hole_bits);
+}
+
+BoardFeatures board_features(const Board &board) {
+	std::array<int, GRID_WIDTH> h{};
+	for (int x = 0; x < GRID_WIDTH; ++x) {
+		h[static_cast<size_t>(x)] = GRID_HEIGHT - board.surface_y(x);
+	}
+	BoardFeatures out{};
+	for (size_t x = 0; x < h.size(); ++x) {
+		out.height += h[x];
+		if (x > 0) {
+			out.bumpiness += std::abs(h[x] - h[x - 1]);
+		}
+		// walls count as full columns
+		int left = x > 0 ? h[x - 1] : GRID_HEIGHT;
+		int right = x + 1 < h.size() ? h[x + 1] : GRID_HEIGHT;
+		int depth = std::min(left, right) - h[x];
+		if (depth > 0) {
+			out.wells += depth * (depth + 1) / 2;
+		}
+	}
+	out.holes = count_holes(board);
+	return out;
+}
+
+double evaluate_board(const Board &board, int cleared, const BotWeights &weights) {
+	BoardFeatures f = board_features(board);
+	return weights.height * f.height + weights.holes * f.holes +
+		   weights.bumpiness * f.bumpiness + weights.wells * f.wells +
+		   weights.clears * calculate_score(cleared);
+}
+
+size_t GreedyPolicy::choose(const GameState &state, const PlacementList &placements) {
+	size_t best = 0;
+	double best_score = -std::numeric_limits<double>::infinity();
+	for (size_t i = 0; i < placements.count; ++i) {
+		auto blocks = placement_blocks(placements.items[i]);
+		// a piece locked above the board loses, only take it when nothing else fits
+		bool lost = false;
+		for (const auto &b : blocks) {
+			lost |= b.pos.y < 0;
+		}
+
+		Board next = state.board;
+		next.place(blocks);
+		int cleared = clear_blocks(next, blocks).count;
+		double score = lost ? -1e9 : evaluate_board(next, cleared, weights);
+		if (score > best_score) {
+			best_score = score;
+			best = i;
+		}
+	}
+	return best;
+}
+
+bool BeamPolicy::hold(const GameState &state) {
+	thought = bot.think(state, move);
+	return thought && move.hold;
+}
+
+size_t BeamPolicy::choose(const GameState &state, const PlacementList &placements) {
+	// the move was thought out by `hold`, unless it was not asked
+	if (!thought) {
+		bot.think(state, move);
+	}
+	thought = false;
+	for (size_t i = 0; i < placements.count; ++i) {
+		const auto &p = placements.items[i];
+		if (p.type == move.placement.type && p.idx == move.placement.idx &&
+			p.x == move.placement.x && p.y == move.placement.y) {
+			return i;
+		}
+	}
+	return 0;
+}
+
+size_t ScriptedPolicy::choose(const GameState & /*state*/, const PlacementList &placements) {
+	ScriptedMove move = script[next];
+	next = (next + 1) % script.size();
+
+	size_t found = 0;
+	bool any = false;
+	for (size_t i = 0; i < placements.count; ++i) {
+		const auto &p = placements.items[i];
+		if (p.idx != move.idx || p.x != move.x) {
+			continue;
+		}
+		if (!any || p.y < placements.items[found].y) {
+			found = i;
+			any = true;
+		}
+	}
+	return found;
+}
+
+bool parse_script(const std::string &text, std::vector<ScriptedMove> &out) {
+	const char *c = text.c_str();
+	while (*c != '\0') {
+		char *end = nullptr;
+		long idx = std::strtol(c, &end, 10);
+		if (end == c || *end != ':' || idx < 0 || idx > 3) {
+			return false;
+		}
+		c = end + 1;
+		long x = std::strtol(c, &end, 10);
+		if (end == c || x < MOVEGEN_MIN_X || x >= GRID_WIDTH) {
+			return false;
+		}
+		out.push_back({.idx = static_cast<uint8_t>(idx), .x = static_cast<int8_t>(x)});
+		c = end;
+		if (*c == ',') {
+			++c;
+		} else if (*c != '\0') {
+			return false;
+		}
+	}
+	return !out.empty();
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "board.hpp"
+#include "bot.hpp"
+#include "game.hpp"
+#include "movegen.hpp"
+
+// Picks where the active piece goes, for games played without a human.
+class Policy {
+  public:
+	virtual ~Policy() = default;
+
+	// Index into `placements` of the one to play. `placements` are the placements
+	// of `state.tet` and never empty.
+	virtual size_t choose(const GameState &state, const PlacementList &placements) = 0;
+	// Whether to hold the active piece before choosing, asked once per piece
+	virtual bool hold(const GameState & /*state*/) { return false; }
+};
+
+// Any reachable placement, uniformly.
+class RandomPolicy : public Policy {
+  private:
+	std::minstd_rand rng;
+
+  public:
+	explicit RandomPolicy(uint32_t seed) : rng{seed} {}
+	size_t choose(const GameState &state, const PlacementList &placements) override;
+};
+
+// The placement that leaves the best board by `evaluate_board`, one piece ahead.
+class GreedyPolicy : public Policy {
+  private:
+	BotWeights weights;
+
+  public:
+	explicit GreedyPolicy(const BotWeights &board_weights = {})
+		: weights{board_weights} {}
+	size_t choose(const GameState &state, const PlacementList &placements) override;
+};
+
+// Plays the moves of a `BeamBot`, holding when it says so.
+class BeamPolicy : public Policy {
+  private:
+	BeamBot bot;
+	BotMove move{};
+	bool thought = false; // `move` is for the piece being chosen for
+
+  public:
+	explicit BeamPolicy(const BotConfig &config) : bot{config} {}
+	bool hold(const GameState &state) override;
+	size_t choose(const GameState &state, const PlacementList &placements) override;
+};
+
+// A fixed move per piece, cycled
+struct ScriptedMove {
+	uint8_t idx; // orientation
+	int8_t x;	 // pattern offset
+};
+
+// Plays the moves of a script in order, as hard drops: the topmost placement with
+// the scripted orientation and offset. Falls back to the first placement when the
+// scripted one is not reachable.
+class ScriptedPolicy : public Policy {
+  private:
+	std::vector<ScriptedMove> script;
+	size_t next = 0;
+
+  public:
+	explicit ScriptedPolicy(std::vector<ScriptedMove> moves) : script{std::move(moves)} {}
+	size_t choose(const GameState &state, const PlacementList &placements) override;
+};
+
+// Parses a script like "0:3,1:-1,2:4", one `idx:x` pair per move. Returns false
+// when `text` is malformed.
+bool parse_script(const std::string &text, std::vector<ScriptedMove> &out);
+
+// What the board heuristic looks at, see `BotWeights`
+struct BoardFeatures {
+	int height = 0;
+	int holes = 0;
+	int bumpiness = 0;
+	int wells = 0;
+};
+BoardFeatures board_features(const Board &board);
+
+// Rates a board after a lock that cleared `cleared` rows, higher is better. The
+// same weighted sum `BeamBot` scores its boards with.
+double evaluate_board(const Board &board, int cleared, const BotWeights &weights);
+
+// Empty cells of `board` with a filled cell anywhere above them in their column
+int count_holes(const Board &board);
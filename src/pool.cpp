@@ -0,0 +1,69 @@
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "pool.hpp"
+
+struct WorkerQueue {
+	std::mutex lock;
+	std::deque<size_t> tasks;
+};
+
+static std::optional<size_t> pop_back(WorkerQueue &queue) {
+	std::lock_guard guard(queue.lock);
+	if (queue.tasks.empty()) {
+		return std::nullopt;
+	}
+	size_t task = queue.tasks.back();
+	queue.tasks.pop_back();
+	return task;
+}
+
+static std::optional<size_t> pop_front(WorkerQueue &queue) {
+	std::lock_guard guard(queue.lock);
+	if (queue.tasks.empty()) {
+		return std::nullopt;
+	}
+	size_t task = queue.tasks.front();
+	queue.tasks.pop_front();
+	return task;
+}
+
+void run_parallel(
+	size_t count, size_t threads, const std::function<void(size_t, size_t)> &task
+) {
+	threads = std::clamp<size_t>(threads, 1, std::max<size_t>(count, 1));
+	std::vector<WorkerQueue> queues(threads);
+	for (size_t w = 0; w < threads; ++w) {
+		for (size_t i = w * count / threads; i < (w + 1) * count / threads; ++i) {
+			queues[w].tasks.push_back(i);
+		}
+	}
+
+	// no task is added once the workers start, so a worker that finds every queue
+	// empty is done
+	auto work = [&](size_t worker) {
+		for (;;) {
+			auto next = pop_back(queues[worker]);
+			for (size_t k = 1; !next.has_value() && k < threads; ++k) {
+				next = pop_front(queues[(worker + k) % threads]);
+			}
+			if (!next.has_value()) {
+				return;
+			}
+			task(*next, worker);
+		}
+	};
+
+	std::vector<std::thread> pool;
+	for (size_t w = 1; w < threads; ++w) {
+		pool.emplace_back(work, w);
+	}
+	work(0);
+	for (auto &t : pool) {
+		t.join();
+	}
+}
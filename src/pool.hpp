@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+// Calls `task(i, worker)` for every `i` in [0, `count`) on `threads` threads and
+// returns once all of them are done. `worker` is the index of the calling thread,
+// below `threads`, so tasks can use per thread scratch space without locking.
+//
+// Every thread starts with its own contiguous share of the tasks and takes them
+// from the back. A thread that runs out steals from the front of another's share,
+// so uneven tasks (a game that lasts much longer than the others) do not leave
+// cores idle at the end.
+void run_parallel(
+	size_t count, size_t threads, const std::function<void(size_t, size_t)> &task
+);
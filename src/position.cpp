@@ -0,0 +1,159 @@
+#include <algorithm>
+
+#include "position.hpp"
+
+// What a key is of, kept in the top bits so no two features share a key
+const uint64_t FEATURE_ROW = 1ULL << 56;
+const uint64_t FEATURE_PIECE = 2ULL << 56;
+const uint64_t FEATURE_HOLD = 3ULL << 56;
+const uint64_t FEATURE_QUEUE = 4ULL << 56;
+
+// splitmix64's finalizer, turns every distinct feature into an unrelated key
+static uint64_t key(uint64_t feature) {
+	uint64_t z = feature + 0x9e3779b97f4a7c15;
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+	return z ^ (z >> 31);
+}
+
+uint64_t zobrist_row(int y, Row row) {
+	if (row_empty(row)) {
+		return 0;
+	}
+	return key(FEATURE_ROW | static_cast<uint64_t>(y) << 32 | row);
+}
+
+uint64_t zobrist_rows(const Board &board, int begin, int end) {
+	uint64_t h = 0;
+	for (int y = begin; y < end; ++y) {
+		h ^= zobrist_row(y, board.row(y));
+	}
+	return h;
+}
+
+uint64_t zobrist_piece(const Tetramino &tet) {
+	return key(
+		FEATURE_PIECE | static_cast<uint64_t>(tet.get_type()) << 24 |
+		static_cast<uint64_t>(tet.get_pattern_idx()) << 16 |
+		static_cast<uint64_t>(static_cast<uint8_t>(tet.get_x_offset())) << 8 |
+		static_cast<uint8_t>(tet.get_y_offset())
+	);
+}
+
+uint64_t zobrist_hold(const std::optional<Tetramino> &hold) {
+	if (!hold.has_value()) {
+		return 0;
+	}
+	return key(FEATURE_HOLD | hold->get_type());
+}
+
+uint64_t zobrist_queue(const Randomizer &randomizer) {
+	uint64_t h = 0;
+	size_t shown = std::min(randomizer.preview_depth(), POSITION_QUEUE);
+	for (size_t i = 0; i < shown; ++i) {
+		h ^= key(FEATURE_QUEUE | i << 8 | randomizer.peek(i));
+	}
+	return h;
+}
+
+uint64_t position_hash(const GameState &st) {
+	return zobrist_rows(st.board, 0, GRID_HEIGHT) ^ zobrist_piece(st.tet) ^
+		   zobrist_hold(st.hold_tet) ^ zobrist_queue(st.randomizer);
+}
+
+// Three bits of a piece, 7 for none
+static uint8_t piece_bits(const std::optional<PieceType> &piece) {
+	return piece.has_value() ? *piece : 7;
+}
+
+static_assert(GRID_WIDTH <= 24, "a row and a partial byte must fit in 32 bits");
+
+PackedPosition pack_position(const GameState &st) {
+	PackedPosition out{};
+	// rows go through `bits` a whole row at a time and come out a byte at a time
+	uint32_t bits = 0;
+	int count = 0;
+	size_t at = 0;
+	for (int y = 0; y < GRID_HEIGHT; ++y) {
+		bits |= static_cast<uint32_t>(st.board.row(y)) << count;
+		for (count += GRID_WIDTH; count >= 8; count -= 8) {
+			out[at++] = static_cast<uint8_t>(bits);
+			bits >>= 8;
+		}
+	}
+	if (count > 0) {
+		out[at] = static_cast<uint8_t>(bits);
+	}
+
+	uint8_t *piece = out.data() + POSITION_BOARD_BYTES;
+	std::optional<PieceType> hold;
+	if (st.hold_tet.has_value()) {
+		hold = st.hold_tet->get_type();
+	}
+	piece[0] = static_cast<uint8_t>(
+		st.tet.get_type() | st.tet.get_pattern_idx() << 3 | piece_bits(hold) << 5
+	);
+	piece[1] = static_cast<uint8_t>(st.tet.get_x_offset());
+	piece[2] = static_cast<uint8_t>(st.tet.get_y_offset());
+
+	uint32_t queue = 0;
+	size_t shown = std::min(st.randomizer.preview_depth(), POSITION_QUEUE);
+	for (size_t i = 0; i < POSITION_QUEUE; ++i) {
+		std::optional<PieceType> next;
+		if (i < shown) {
+			next = st.randomizer.peek(i);
+		}
+		queue |= static_cast<uint32_t>(piece_bits(next)) << (3 * i);
+	}
+	for (size_t i = 0; i < POSITION_BYTES - POSITION_BOARD_BYTES - 3; ++i) {
+		piece[3 + i] = static_cast<uint8_t>(queue >> (8 * i));
+	}
+	return out;
+}
+
+// Reads three bits of a piece, false when they are not a piece or 7
+static bool read_piece(unsigned bits, std::optional<PieceType> &out) {
+	if (bits == 7) {
+		out.reset();
+	} else if (bits < PIECE_COUNT) {
+		out = static_cast<PieceType>(bits);
+	} else {
+		return false;
+	}
+	return true;
+}
+
+bool unpack_position(const PackedPosition &in, Position &out) {
+	const uint8_t *piece = in.data() + POSITION_BOARD_BYTES;
+	if ((piece[0] & 7U) >= PIECE_COUNT || !read_piece(piece[0] >> 5U, out.hold)) {
+		return false;
+	}
+	uint32_t queue = 0;
+	for (size_t i = 0; i < POSITION_BYTES - POSITION_BOARD_BYTES - 3; ++i) {
+		queue |= static_cast<uint32_t>(piece[3 + i]) << (8 * i);
+	}
+	for (size_t i = 0; i < POSITION_QUEUE; ++i) {
+		if (!read_piece((queue >> (3 * i)) & 7U, out.queue[i])) {
+			return false;
+		}
+	}
+
+	out.piece = {
+		.type = static_cast<PieceType>(piece[0] & 7U),
+		.idx = static_cast<uint8_t>((piece[0] >> 3U) & 3U),
+		.x = static_cast<int8_t>(piece[1]),
+		.y = static_cast<int8_t>(piece[2]),
+	};
+	uint32_t bits = 0;
+	int count = 0;
+	size_t at = 0;
+	for (auto &row : out.rows) {
+		for (; count < GRID_WIDTH; count += 8) {
+			bits |= static_cast<uint32_t>(in[at++]) << count;
+		}
+		row = static_cast<Row>(bits & Board::FULL_ROW);
+		bits >>= GRID_WIDTH;
+		count -= GRID_WIDTH;
+	}
+	return true;
+}
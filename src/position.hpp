@@ -0,0 +1,54 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+#include "game.hpp"
+
+// Identity of a game position: the board occupancy, the active piece with its
+// orientation and offset, the held piece and the first `POSITION_QUEUE` pieces of
+// the preview. Score, gravity and colors are not part of it.
+//
+// The hash is a Zobrist hash, the XOR of one random key per feature of the
+// position, so a change is a couple of XORs instead of a rescan. A row is one
+// feature keyed by its row index and mask rather than one key per cell, a line
+// clear moves whole rows and rekeying a row is then a single key. Keys are mixed
+// from the feature on the fly instead of read from a table. `Game` keeps the hash
+// of its position up to date in `GameState::hash`.
+const size_t POSITION_QUEUE = 5;
+
+// Key of row `y` holding `row`, an empty row has none
+uint64_t zobrist_row(int y, Row row);
+// XOR of the keys of rows [`begin`, `end`)
+uint64_t zobrist_rows(const Board &board, int begin, int end);
+uint64_t zobrist_piece(const Tetramino &tet);
+uint64_t zobrist_hold(const std::optional<Tetramino> &hold);
+uint64_t zobrist_queue(const Randomizer &randomizer);
+
+// The hash from scratch, what `GameState::hash` is kept equal to
+uint64_t position_hash(const GameState &st);
+
+// Fixed size encoding of a position, for storing and comparing positions
+// byte for byte:
+//  - the board, one bit per cell row by row from the top, in the first
+//    `POSITION_BOARD_BYTES`
+//  - active piece type | orientation << 3 | held piece << 5, 7 when none held
+//  - active piece x and y offset, signed
+//  - the queue, three bits per piece from the next one up, 7 past the preview
+const size_t POSITION_BOARD_BYTES = (GRID_WIDTH * GRID_HEIGHT + 7) / 8;
+const size_t POSITION_BYTES = POSITION_BOARD_BYTES + 3 + (3 * POSITION_QUEUE + 7) / 8;
+typedef std::array<uint8_t, POSITION_BYTES> PackedPosition;
+
+// A position read back from a `PackedPosition`
+struct Position {
+	std::array<Row, GRID_HEIGHT> rows{};
+	Placement piece{};
+	std::optional<PieceType> hold;
+	std::array<std::optional<PieceType>, POSITION_QUEUE> queue{};
+};
+
+PackedPosition pack_position(const GameState &st);
+// Returns false when `in` holds a piece type out of range.
+bool unpack_position(const PackedPosition &in, Position &out);
@@ -0,0 +1,140 @@
+#include <algorithm>
+#include <cstdio>
+
+#include "profiler.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+std::atomic<bool> profiler_enabled{false};
+
+// Written by one thread, read by any. Events are relaxed atomics so a reader
+// racing the writer sees whole values, `written` tells it which ones may have been
+// overwritten while it was reading.
+struct ProfileRing {
+	std::array<std::atomic<uint64_t>, PROFILE_RING_SIZE> starts;
+	// duration in ns shifted left by 8, phase in the low byte
+	std::array<std::atomic<uint64_t>, PROFILE_RING_SIZE> infos;
+	std::atomic<uint64_t> written{0};
+};
+
+struct ProfileEvent {
+	uint64_t start_ns;
+	uint64_t duration_ns;
+	ProfilePhase phase;
+};
+
+static std::array<ProfileRing, PROFILE_MAX_THREADS> rings;
+static std::atomic<size_t> ring_count{0};
+static thread_local ProfileRing *thread_ring = nullptr;
+static thread_local bool thread_dropped = false;
+
+static const Clock::time_point epoch = Clock::now();
+
+uint64_t profile_now() {
+	// never 0, `ProfileScope` uses that for a scope started while disabled
+	auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - epoch);
+	return static_cast<uint64_t>(ns.count()) + 1;
+}
+
+void record_phase(ProfilePhase phase, uint64_t start_ns, uint64_t end_ns) {
+	if (thread_ring == nullptr) {
+		if (thread_dropped) {
+			return;
+		}
+		size_t i = ring_count.fetch_add(1, std::memory_order_relaxed);
+		if (i >= PROFILE_MAX_THREADS) {
+			thread_dropped = true;
+			return;
+		}
+		thread_ring = &rings[i];
+	}
+
+	ProfileRing &ring = *thread_ring;
+	uint64_t n = ring.written.load(std::memory_order_relaxed);
+	size_t slot = n % PROFILE_RING_SIZE;
+	ring.starts[slot].store(start_ns, std::memory_order_relaxed);
+	ring.infos[slot].store(((end_ns - start_ns) << 8) | phase, std::memory_order_relaxed);
+	ring.written.store(n + 1, std::memory_order_release);
+}
+
+// Calls `f(event, thread)` for every event still intact in the rings.
+template <class F> static void for_each_event(F &&f) {
+	size_t threads =
+		std::min(ring_count.load(std::memory_order_acquire), PROFILE_MAX_THREADS);
+	for (size_t t = 0; t < threads; ++t) {
+		const ProfileRing &ring = rings[t];
+		uint64_t end = ring.written.load(std::memory_order_acquire);
+		uint64_t begin = end > PROFILE_RING_SIZE ? end - PROFILE_RING_SIZE : 0;
+		for (uint64_t i = begin; i < end; ++i) {
+			size_t slot = i % PROFILE_RING_SIZE;
+			ProfileEvent ev{
+				.start_ns = ring.starts[slot].load(std::memory_order_relaxed),
+				.duration_ns = 0,
+				.phase = PHASE_COUNT,
+			};
+			uint64_t info = ring.infos[slot].load(std::memory_order_relaxed);
+			// skip the slots the writer has reused since `end` was read
+			std::atomic_thread_fence(std::memory_order_acquire);
+			uint64_t now = ring.written.load(std::memory_order_acquire);
+			if (now > i + PROFILE_RING_SIZE) {
+				continue;
+			}
+			ev.duration_ns = info >> 8;
+			ev.phase = static_cast<ProfilePhase>(info & 0xff);
+			f(ev, t);
+		}
+	}
+}
+
+void profile_stats(std::array<PhaseStats, PHASE_COUNT> &out) {
+	static std::array<uint32_t, PROFILE_RING_SIZE * PROFILE_MAX_THREADS> durations;
+
+	for (size_t phase = 0; phase < PHASE_COUNT; ++phase) {
+		size_t n = 0;
+		for_each_event([&](const ProfileEvent &ev, size_t) {
+			if (ev.phase == phase && n < durations.size()) {
+				durations[n++] =
+					static_cast<uint32_t>(std::min<uint64_t>(ev.duration_ns, UINT32_MAX));
+			}
+		});
+
+		PhaseStats &stats = out[phase];
+		stats = PhaseStats{};
+		if (n == 0) {
+			continue;
+		}
+		auto first = durations.begin();
+		auto last = first + static_cast<long>(n);
+		stats.count = static_cast<uint32_t>(n);
+		std::nth_element(first, first + static_cast<long>(n / 2), last);
+		stats.p50_ns = durations[n / 2];
+		std::nth_element(first, first + static_cast<long>(n * 99 / 100), last);
+		stats.p99_ns = durations[n * 99 / 100];
+		stats.max_ns = *std::max_element(first, last);
+	}
+}
+
+bool write_chrome_trace(const char *path) {
+	FILE *f = std::fopen(path, "w");
+	if (f == nullptr) {
+		return false;
+	}
+	std::fprintf(f, "{\"traceEvents\": [\n");
+	bool first = true;
+	for_each_event([&](const ProfileEvent &ev, size_t thread) {
+		// times are in microseconds
+		std::fprintf(
+			f,
+			"%s{\"name\": \"%s\", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, "
+			"\"pid\": 1, \"tid\": %zu}",
+			first ? "" : ",\n",
+			PHASE_NAMES[ev.phase],
+			static_cast<double>(ev.start_ns) / 1000.0,
+			static_cast<double>(ev.duration_ns) / 1000.0,
+			thread
+		);
+		first = false;
+	});
+	std::fprintf(f, "\n], \"displayTimeUnit\": \"ns\"}\n");
+	return std::fclose(f) == 0;
+}
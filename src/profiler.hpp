@@ -0,0 +1,81 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// Parts of a frame that are timed. A phase can run inside another, `PHASE_STEP`
+// contains the collision checks and the line clear.
+enum ProfilePhase : uint8_t {
+	PHASE_FRAME = 0,  // one whole frame of the game loop
+	PHASE_INPUT,	  // polling keys or reading the replay
+	PHASE_STEP,		  // `Game::step`
+	PHASE_COLLISION,  // `check_all_collisions`
+	PHASE_CLEAR,	  // `clear_blocks`
+	PHASE_GHOST,	  // finding where the piece would land
+	PHASE_DRAW,		  // building the frame, up to `EndDrawing`
+	PHASE_PRESENT,	  // `EndDrawing`, the buffer swap and the frame rate wait
+	PHASE_COUNT,
+};
+
+const std::array<const char *, PHASE_COUNT> PHASE_NAMES = {
+	"frame", "input", "step", "collision", "clear", "ghost", "draw", "present",
+};
+
+// Events kept per thread, the oldest are overwritten
+const size_t PROFILE_RING_SIZE = 1 << 14;
+// Threads that can record, events from any further thread are dropped
+const size_t PROFILE_MAX_THREADS = 4;
+
+extern std::atomic<bool> profiler_enabled;
+
+inline void set_profiling(bool on) {
+	profiler_enabled.store(on, std::memory_order_relaxed);
+}
+inline bool profiling() { return profiler_enabled.load(std::memory_order_relaxed); }
+
+// Adds a finished phase to the ring of the calling thread. Never allocates or
+// locks.
+void record_phase(ProfilePhase phase, uint64_t start_ns, uint64_t end_ns);
+// Nanoseconds on the clock events are recorded with
+uint64_t profile_now();
+
+// Times the enclosing scope as `phase`. While profiling is off this is a relaxed
+// load and a branch.
+class ProfileScope {
+  private:
+	ProfilePhase phase;
+	uint64_t start = 0;
+
+  public:
+	explicit ProfileScope(ProfilePhase timed) : phase{timed} {
+		if (profiling()) {
+			start = profile_now();
+		}
+	}
+	~ProfileScope() {
+		if (start != 0) {
+			record_phase(phase, start, profile_now());
+		}
+	}
+	ProfileScope(const ProfileScope &) = delete;
+	ProfileScope &operator=(const ProfileScope &) = delete;
+};
+
+struct PhaseStats {
+	uint32_t count = 0;
+	uint64_t p50_ns = 0;
+	uint64_t p99_ns = 0;
+	uint64_t max_ns = 0;
+};
+
+// Percentiles of every phase over the events still in the rings. Does not
+// allocate, but takes a while, a few times a second is plenty. Only one thread
+// may call it at a time.
+void profile_stats(std::array<PhaseStats, PHASE_COUNT> &out);
+
+// Writes the events in the rings as Chrome `trace_event` JSON, for
+// chrome://tracing or Perfetto. Returns false when `path` cannot be written.
+bool write_chrome_trace(const char *path);
@@ -0,0 +1,272 @@
+#include <cstring>
+
+#include "protocol.hpp"
+
+static void put_u16(std::vector<uint8_t> &out, uint16_t v) {
+	out.push_back(static_cast<uint8_t>(v));
+	out.push_back(static_cast<uint8_t>(v >> 8));
+}
+
+static void put_u32(std::vector<uint8_t> &out, uint32_t v) {
+	for (int i = 0; i < 4; ++i) {
+		out.push_back(static_cast<uint8_t>(v >> (8 * i)));
+	}
+}
+
+static uint16_t get_u16(const uint8_t *p) {
+	return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+static uint32_t get_u32(const uint8_t *p) {
+	return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+// Starts a frame, `end_frame` fills in its length once the body is written.
+static size_t begin_frame(std::vector<uint8_t> &out, MessageType type) {
+	size_t at = out.size();
+	put_u16(out, 0);
+	out.push_back(type);
+	return at;
+}
+
+static void end_frame(std::vector<uint8_t> &out, size_t at) {
+	auto len = static_cast<uint16_t>(out.size() - at - 2);
+	out[at] = static_cast<uint8_t>(len);
+	out[at + 1] = static_cast<uint8_t>(len >> 8);
+}
+
+void write_join(std::vector<uint8_t> &out, uint32_t seed) {
+	size_t at = begin_frame(out, MSG_JOIN);
+	put_u32(out, seed);
+	end_frame(out, at);
+}
+
+void write_input(std::vector<uint8_t> &out, uint32_t game, Inputs inputs) {
+	size_t at = begin_frame(out, MSG_INPUT);
+	put_u32(out, game);
+	out.push_back(inputs);
+	end_frame(out, at);
+}
+
+void write_leave(std::vector<uint8_t> &out, uint32_t game) {
+	size_t at = begin_frame(out, MSG_LEAVE);
+	put_u32(out, game);
+	end_frame(out, at);
+}
+
+void write_joined(std::vector<uint8_t> &out, uint32_t game) {
+	size_t at = begin_frame(out, MSG_JOINED);
+	put_u32(out, game);
+	end_frame(out, at);
+}
+
+bool write_diff(
+	std::vector<uint8_t> &out, uint32_t game, uint32_t step, GameView &view,
+	const GameState &st
+) {
+	size_t at = begin_frame(out, MSG_DIFF);
+	put_u32(out, game);
+	put_u32(out, step);
+	size_t flags_at = out.size();
+	out.push_back(0);
+	uint8_t flags = 0;
+
+	size_t count_at = out.size();
+	out.push_back(0);
+	uint8_t count = 0;
+	for (int y = 0; y < GRID_HEIGHT; ++y) {
+		Row row = st.board.row(y);
+		if (row != view.rows[static_cast<size_t>(y)]) {
+			view.rows[static_cast<size_t>(y)] = row;
+			out.push_back(static_cast<uint8_t>(y));
+			put_u16(out, row);
+			++count;
+		}
+	}
+	if (count > 0) {
+		flags |= DIFF_ROWS;
+		out[count_at] = count;
+	} else {
+		out.pop_back();
+	}
+
+	auto piece =
+		static_cast<uint8_t>(st.tet.get_type() | (st.tet.get_pattern_idx() << 4));
+	auto x = static_cast<int8_t>(st.tet.get_x_offset());
+	auto y = static_cast<int8_t>(st.tet.get_y_offset());
+	if (piece != view.piece || x != view.x || y != view.y) {
+		flags |= DIFF_PIECE;
+		view.piece = piece;
+		view.x = x;
+		view.y = y;
+		out.push_back(piece);
+		out.push_back(static_cast<uint8_t>(x));
+		out.push_back(static_cast<uint8_t>(y));
+	}
+	auto next = static_cast<uint8_t>(st.randomizer.peek(0));
+	if (next != view.next) {
+		flags |= DIFF_NEXT;
+		view.next = next;
+		out.push_back(next);
+	}
+	uint8_t hold = NO_PIECE;
+	if (st.hold_tet.has_value()) {
+		hold = static_cast<uint8_t>(st.hold_tet->get_type());
+	}
+	if (hold != view.hold) {
+		flags |= DIFF_HOLD;
+		view.hold = hold;
+		out.push_back(hold);
+	}
+	if (st.score != view.score) {
+		flags |= DIFF_SCORE;
+		view.score = st.score;
+		put_u32(out, st.score);
+	}
+	if (st.over && !view.over) {
+		flags |= DIFF_OVER;
+		view.over = true;
+	}
+
+	if (flags == 0) {
+		out.resize(at);
+		return false;
+	}
+	out[flags_at] = flags;
+	end_frame(out, at);
+	return true;
+}
+
+uint8_t *FrameReader::reserve(size_t len) {
+	// move what is left of a partly received frame to the front
+	if (start > 0) {
+		std::memmove(buf.data(), buf.data() + start, end - start);
+		end -= start;
+		start = 0;
+	}
+	if (buf.size() < end + len) {
+		buf.resize(end + len);
+	}
+	return buf.data() + end;
+}
+
+void FrameReader::received(size_t len) { end += len; }
+
+bool FrameReader::next(const uint8_t *&body, size_t &len) {
+	if (invalid || end - start < 2) {
+		return false;
+	}
+	size_t frame = get_u16(buf.data() + start);
+	if (frame == 0 || frame > MAX_FRAME) {
+		invalid = true;
+		return false;
+	}
+	if (end - start < 2 + frame) {
+		return false;
+	}
+	body = buf.data() + start + 2;
+	len = frame;
+	start += 2 + frame;
+	return true;
+}
+
+bool read_join(const uint8_t *body, size_t len, uint32_t &seed) {
+	if (len < 5 || body[0] != MSG_JOIN) {
+		return false;
+	}
+	seed = get_u32(body + 1);
+	return true;
+}
+
+bool read_input(const uint8_t *body, size_t len, uint32_t &game, Inputs &inputs) {
+	if (len < 6 || body[0] != MSG_INPUT) {
+		return false;
+	}
+	game = get_u32(body + 1);
+	inputs = body[5];
+	return true;
+}
+
+bool read_leave(const uint8_t *body, size_t len, uint32_t &game) {
+	if (len < 5 || body[0] != MSG_LEAVE) {
+		return false;
+	}
+	game = get_u32(body + 1);
+	return true;
+}
+
+bool read_joined(const uint8_t *body, size_t len, uint32_t &game) {
+	if (len < 5 || body[0] != MSG_JOINED) {
+		return false;
+	}
+	game = get_u32(body + 1);
+	return true;
+}
+
+bool read_diff_header(const uint8_t *body, size_t len, uint32_t &game, uint32_t &step) {
+	if (len < 10 || body[0] != MSG_DIFF) {
+		return false;
+	}
+	game = get_u32(body + 1);
+	step = get_u32(body + 5);
+	return true;
+}
+
+bool apply_diff(const uint8_t *body, size_t len, GameView &view) {
+	if (len < 10 || body[0] != MSG_DIFF) {
+		return false;
+	}
+	uint8_t flags = body[9];
+	size_t at = 10;
+	// bytes the fields of `flags` take, checked before reading any of them
+	auto has = [&](size_t n) { return at + n <= len; };
+
+	if (flags & DIFF_ROWS) {
+		if (!has(1)) {
+			return false;
+		}
+		size_t count = body[at++];
+		if (!has(3 * count)) {
+			return false;
+		}
+		for (size_t i = 0; i < count; ++i, at += 3) {
+			size_t y = body[at];
+			if (y >= view.rows.size()) {
+				return false;
+			}
+			view.rows[y] = get_u16(body + at + 1);
+		}
+	}
+	if (flags & DIFF_PIECE) {
+		if (!has(3)) {
+			return false;
+		}
+		view.piece = body[at];
+		view.x = static_cast<int8_t>(body[at + 1]);
+		view.y = static_cast<int8_t>(body[at + 2]);
+		at += 3;
+	}
+	if (flags & DIFF_NEXT) {
+		if (!has(1)) {
+			return false;
+		}
+		view.next = body[at++];
+	}
+	if (flags & DIFF_HOLD) {
+		if (!has(1)) {
+			return false;
+		}
+		view.hold = body[at++];
+	}
+	if (flags & DIFF_SCORE) {
+		if (!has(4)) {
+			return false;
+		}
+		view.score = get_u32(body + at);
+		at += 4;
+	}
+	if (flags & DIFF_OVER) {
+		view.over = true;
+	}
+	return true;
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "game.hpp"
+
+// The wire protocol of tetris_server, the same over TCP and Unix sockets.
+//
+// Every message is a frame: its length as a little endian u16, not counting the
+// two length bytes, then a type byte and the payload. Numbers are little endian.
+//
+// Client to server:
+//  - MSG_JOIN, u32 seed: starts a game, the server answers with MSG_JOINED.
+//  - MSG_INPUT, u32 game, u8 inputs: inputs for the next step of a game of this
+//    connection. Several inputs before a step are combined.
+//  - MSG_LEAVE, u32 game: ends a game of this connection.
+// Server to client:
+//  - MSG_JOINED, u32 game: id of the new game, `NO_GAME` when the server is full.
+//  - MSG_DIFF, u32 game, u32 step, u8 flags, then what changed since the previous
+//    diff of the game, in the order of the flags:
+//     - DIFF_ROWS: u8 count, then count times u8 row and u16 row mask
+//     - DIFF_PIECE: u8 type | orientation << 4, i8 x, i8 y
+//     - DIFF_NEXT: u8 type of the next piece
+//     - DIFF_HOLD: u8 type of the held piece, `NO_PIECE` when none
+//     - DIFF_SCORE: u32 score
+//     - DIFF_OVER: no payload, the game is lost and no more diffs follow
+//    The first diff of a game is against an empty board, so it carries the whole
+//    state. Steps where nothing a client sees changed send no diff. Block colors
+//    are not sent, they follow from the piece that settled each block.
+const uint32_t NO_GAME = 0xFFFFFFFF;
+const uint8_t NO_PIECE = 0xFF;
+// Largest frame body, a diff of every row with all other fields is well below it
+const size_t MAX_FRAME = 512;
+
+enum MessageType : uint8_t {
+	MSG_JOIN = 1,
+	MSG_INPUT = 2,
+	MSG_LEAVE = 3,
+	MSG_JOINED = 4,
+	MSG_DIFF = 5,
+};
+
+enum DiffFlag : uint8_t {
+	DIFF_ROWS = 1 << 0,
+	DIFF_PIECE = 1 << 1,
+	DIFF_NEXT = 1 << 2,
+	DIFF_HOLD = 1 << 3,
+	DIFF_SCORE = 1 << 4,
+	DIFF_OVER = 1 << 5,
+};
+
+// What a client knows of a game, everything a diff can change. The server keeps
+// one per game as of the last diff it sent, a client applies diffs to its own.
+struct GameView {
+	std::array<Row, GRID_HEIGHT> rows{};
+	uint8_t piece = NO_PIECE; // type | orientation << 4
+	int8_t x = 0;
+	int8_t y = 0;
+	uint8_t next = NO_PIECE;
+	uint8_t hold = NO_PIECE;
+	uint32_t score = 0;
+	bool over = false;
+};
+
+// Appends a whole frame to `out`.
+void write_join(std::vector<uint8_t> &out, uint32_t seed);
+void write_input(std::vector<uint8_t> &out, uint32_t game, Inputs inputs);
+void write_leave(std::vector<uint8_t> &out, uint32_t game);
+void write_joined(std::vector<uint8_t> &out, uint32_t game);
+// Appends the diff from `view` to `st` and brings `view` up to date. Appends
+// nothing and returns false when a client would see no difference.
+bool write_diff(
+	std::vector<uint8_t> &out, uint32_t game, uint32_t step, GameView &view,
+	const GameState &st
+);
+
+// Splits a byte stream into frames. Bytes are appended as they arrive and whole
+// frames taken off the front, the buffer keeps its capacity.
+class FrameReader {
+  private:
+	std::vector<uint8_t> buf;
+	size_t start = 0; // first byte not taken as a frame yet
+	size_t end = 0;	  // one past the last byte received
+	bool invalid = false;
+
+  public:
+	// Room for at least `len` more bytes, to receive into. Call `received` after.
+	uint8_t *reserve(size_t len);
+	void received(size_t len);
+	// The next whole frame body, valid until the next call to `reserve`. Returns
+	// false when no whole frame is buffered. A frame longer than `MAX_FRAME` makes
+	// the stream invalid, see `broken`.
+	bool next(const uint8_t *&body, size_t &len);
+	bool broken() const { return invalid; }
+};
+
+// Reads the fields of a message body by type. Each returns false when the body
+// is too short or not of that type.
+bool read_join(const uint8_t *body, size_t len, uint32_t &seed);
+bool read_input(const uint8_t *body, size_t len, uint32_t &game, Inputs &inputs);
+bool read_leave(const uint8_t *body, size_t len, uint32_t &game);
+bool read_joined(const uint8_t *body, size_t len, uint32_t &game);
+// Which game and step a diff is for, `apply_diff` then brings that game's view up
+// to date with it.
+bool read_diff_header(const uint8_t *body, size_t len, uint32_t &game, uint32_t &step);
+bool apply_diff(const uint8_t *body, size_t len, GameView &view);
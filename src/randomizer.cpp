@@ -0,0 +1,75 @@
+#include <algorithm>
+#include <random>
+
+#include "randomizer.hpp"
+
+Randomizer::Randomizer() : Randomizer(std::random_device{}()) {}
+
+Randomizer::Randomizer(uint64_t seed, size_t preview)
+	: state{seed}, depth{static_cast<uint8_t>(std::clamp<size_t>(preview, 1, MAX_PREVIEW))} {
+	fill();
+}
+
+uint64_t Randomizer::next_random() {
+	uint64_t z = (state += 0x9e3779b97f4a7c15);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+	return z ^ (z >> 31);
+}
+
+// Appends shuffled bags until `depth` pieces are queued.
+void Randomizer::fill() {
+	while (count < depth) {
+		std::array<PieceType, PIECE_COUNT> bag = {
+			PIECE_I, PIECE_J, PIECE_L, PIECE_T, PIECE_O, PIECE_S, PIECE_Z,
+		};
+		// Fisher-Yates, taking the top bits of a random word times the range instead
+		// of a modulo, the bias is far below anything a game could show
+		for (size_t i = PIECE_COUNT - 1; i > 0; --i) {
+			size_t j = static_cast<size_t>(((next_random() >> 32) * (i + 1)) >> 32);
+			std::swap(bag[i], bag[j]);
+		}
+		for (PieceType piece : bag) {
+			ring[(head + count) % RING_SIZE] = piece;
+			++count;
+		}
+	}
+}
+
+void Randomizer::save(std::array<uint8_t, RANDOMIZER_BYTES> &out) const {
+	out.fill(0);
+	for (size_t i = 0; i < 8; ++i) {
+		out[i] = static_cast<uint8_t>(state >> (8 * i));
+	}
+	out[8] = depth;
+	out[9] = count;
+	for (size_t i = 0; i < count; ++i) {
+		out[10 + i] = peek(i);
+	}
+}
+
+bool Randomizer::load(const std::array<uint8_t, RANDOMIZER_BYTES> &in) {
+	uint8_t new_depth = in[8];
+	uint8_t new_count = in[9];
+	if (new_depth < 1 || new_depth > MAX_PREVIEW || new_count < new_depth ||
+		new_count > RING_SIZE || 10U + new_count > RANDOMIZER_BYTES) {
+		return false;
+	}
+	for (size_t i = 0; i < new_count; ++i) {
+		if (in[10 + i] >= PIECE_COUNT) {
+			return false;
+		}
+	}
+
+	state = 0;
+	for (size_t i = 0; i < 8; ++i) {
+		state |= static_cast<uint64_t>(in[i]) << (8 * i);
+	}
+	depth = new_depth;
+	count = new_count;
+	head = 0;
+	for (size_t i = 0; i < count; ++i) {
+		ring[i] = static_cast<PieceType>(in[10 + i]);
+	}
+	return true;
+}
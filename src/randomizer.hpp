@@ -0,0 +1,63 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "pieces.hpp"
+
+// Deepest preview a randomizer can keep
+const size_t MAX_PREVIEW = 16;
+// Size of `Randomizer::save`: generator state, depth, queue length and the queue
+const size_t RANDOMIZER_BYTES = 8 + 1 + 1 + 32;
+
+// The piece sequence of one game: every run of seven pieces is a shuffled bag of
+// all seven, the way the original bag worked. Upcoming pieces sit in a ring that
+// is refilled a whole bag at a time, so a draw is a ring read and a shuffle only
+// happens once every seven draws.
+//
+// Everything is plain values, a copy continues the same sequence independently,
+// and games on different threads never share anything.
+class Randomizer {
+  private:
+	static constexpr size_t RING_SIZE = 32; // holds MAX_PREVIEW plus a bag
+	static_assert(MAX_PREVIEW - 1 + PIECE_COUNT <= RING_SIZE);
+
+	uint64_t state = 0; // splitmix64
+	std::array<PieceType, RING_SIZE> ring{};
+	uint8_t head = 0;
+	uint8_t count = 0;
+	uint8_t depth = 1;
+
+	uint64_t next_random();
+	void fill();
+
+  public:
+	// Seeded from `std::random_device`
+	Randomizer();
+	// The same `seed` always gives the same sequence. `preview` pieces are kept
+	// ready, between 1 and `MAX_PREVIEW`.
+	explicit Randomizer(uint64_t seed, size_t preview = 5);
+
+	// Takes the next piece off the queue.
+	PieceType draw() {
+		PieceType piece = ring[head];
+		head = static_cast<uint8_t>((head + 1) % RING_SIZE);
+		--count;
+		if (count < depth) {
+			fill();
+		}
+		return piece;
+	}
+
+	// The `i`th piece after the next draw, `peek(0)` is what `draw` returns. `i`
+	// must be below `preview_depth`.
+	PieceType peek(size_t i) const { return ring[(head + i) % RING_SIZE]; }
+	size_t preview_depth() const { return depth; }
+
+	// Writes the complete state to `out`, `load` continues the sequence from it.
+	void save(std::array<uint8_t, RANDOMIZER_BYTES> &out) const;
+	// Returns false, and leaves the randomizer untouched, when `in` was not
+	// written by `save`.
+	bool load(const std::array<uint8_t, RANDOMIZER_BYTES> &in);
+};
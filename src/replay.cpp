@@ -0,0 +1,200 @@
+#include <cstring>
+
+#include "replay.hpp"
+
+const std::array<uint8_t, 4> REPLAY_MAGIC = {'T', 'T', 'R', 'P'};
+
+// FNV-1a, folds what is not part of the position into its hash
+static void hash_bytes(uint64_t &h, uint64_t value, int bytes) {
+	for (int i = 0; i < bytes; ++i) {
+		h ^= (value >> (8 * i)) & 0xff;
+		h *= 0x100000001b3;
+	}
+}
+
+uint32_t state_hash(const GameState &st) {
+	uint64_t h = st.hash;
+	hash_bytes(h, st.fall_progress, 4);
+	hash_bytes(h, static_cast<uint32_t>(st.lock_time), 4);
+	hash_bytes(h, static_cast<uint32_t>(st.lock_resets_left), 4);
+	hash_bytes(h, st.score, 4);
+	hash_bytes(h, st.held ? 1 : 0, 1);
+	return static_cast<uint32_t>(h ^ (h >> 32));
+}
+
+void ReplayWriter::put_varint(uint64_t value) {
+	// a varint is at most 10 bytes
+	if (buf.size() - len < 10) {
+		flush();
+	}
+	while (value >= 0x80) {
+		buf[len++] = static_cast<uint8_t>(value | 0x80);
+		value >>= 7;
+	}
+	buf[len++] = static_cast<uint8_t>(value);
+}
+
+void ReplayWriter::put_record(ReplayRecord kind) {
+	put_varint(((tick - last_record) << 2) | kind);
+	last_record = tick;
+}
+
+void ReplayWriter::flush() {
+	if (len > 0) {
+		std::fwrite(buf.data(), 1, len, file);
+		len = 0;
+	}
+}
+
+bool ReplayWriter::open(
+	const char *path, uint32_t seed, int tick_rate, const GravityConfig &gravity
+) {
+	close();
+	file = std::fopen(path, "wb");
+	if (file == nullptr) {
+		return false;
+	}
+	// writes go through `buf`, stdio does not need to allocate its own
+	std::setvbuf(file, nullptr, _IONBF, 0);
+	tick = 0;
+	last_record = 0;
+	std::memcpy(buf.data(), REPLAY_MAGIC.data(), REPLAY_MAGIC.size());
+	len = REPLAY_MAGIC.size();
+	buf[len++] = REPLAY_VERSION;
+	put_varint(seed);
+	put_varint(static_cast<uint64_t>(tick_rate));
+	put_varint(gravity.gravity);
+	put_varint(static_cast<uint64_t>(gravity.lock_delay_ms));
+	put_varint(static_cast<uint64_t>(gravity.lock_resets));
+	return true;
+}
+
+void ReplayWriter::record(Inputs inputs, const GameState &st) {
+	if (file == nullptr) {
+		return;
+	}
+	if (inputs != INPUT_NONE) {
+		put_record(REPLAY_INPUT);
+		put_varint(inputs);
+	}
+	if ((tick + 1) % REPLAY_HASH_INTERVAL == 0) {
+		put_record(REPLAY_HASH);
+		put_varint(state_hash(st));
+	}
+	++tick;
+}
+
+void ReplayWriter::close() {
+	if (file == nullptr) {
+		return;
+	}
+	put_record(REPLAY_END);
+	flush();
+	std::fclose(file);
+	file = nullptr;
+}
+
+bool ReplayReader::get_varint(uint64_t &value) {
+	value = 0;
+	for (int shift = 0; shift < 64; shift += 7) {
+		if (pos >= data.size()) {
+			return false;
+		}
+		uint8_t byte = data[pos++];
+		value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+		if ((byte & 0x80) == 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// A damaged or cut off file is treated as ending here
+void ReplayReader::stop() {
+	corrupt = true;
+	next_kind = REPLAY_END;
+	next_tick = tick;
+}
+
+void ReplayReader::read_record() {
+	uint64_t head = 0;
+	if (!get_varint(head) || (head & 3) > REPLAY_END) {
+		stop();
+		return;
+	}
+	next_kind = static_cast<ReplayRecord>(head & 3);
+	next_tick += head >> 2;
+}
+
+bool ReplayReader::load(const char *path) {
+	FILE *f = std::fopen(path, "rb");
+	if (f == nullptr) {
+		return false;
+	}
+	data.clear();
+	std::array<uint8_t, 4096> chunk{};
+	size_t n = 0;
+	while ((n = std::fread(chunk.data(), 1, chunk.size(), f)) > 0) {
+		data.insert(data.end(), chunk.begin(), chunk.begin() + static_cast<long>(n));
+	}
+	std::fclose(f);
+
+	if (data.size() < REPLAY_MAGIC.size() + 1 ||
+		std::memcmp(data.data(), REPLAY_MAGIC.data(), REPLAY_MAGIC.size()) != 0 ||
+		data[REPLAY_MAGIC.size()] != REPLAY_VERSION) {
+		return false;
+	}
+	pos = REPLAY_MAGIC.size() + 1;
+	uint64_t seed = 0;
+	uint64_t rate = 0;
+	uint64_t gravity = 0;
+	uint64_t lock_delay = 0;
+	uint64_t lock_resets = 0;
+	if (!get_varint(seed) || seed > UINT32_MAX || !get_varint(rate) || rate == 0 ||
+		rate > INT32_MAX || !get_varint(gravity) || gravity > UINT32_MAX ||
+		!get_varint(lock_delay) || lock_delay > INT32_MAX || !get_varint(lock_resets) ||
+		lock_resets > INT32_MAX) {
+		return false;
+	}
+	game_seed = static_cast<uint32_t>(seed);
+	game_tick_rate = static_cast<int>(rate);
+	game_gravity = {
+		.gravity = static_cast<uint32_t>(gravity),
+		.lock_delay_ms = static_cast<int>(lock_delay),
+		.lock_resets = static_cast<int>(lock_resets),
+	};
+	tick = 0;
+	next_tick = 0;
+	corrupt = false;
+	read_record();
+	return true;
+}
+
+bool ReplayReader::next(ReplayStep &out) {
+	out = ReplayStep{};
+	if (next_kind == REPLAY_END && next_tick <= tick) {
+		return false;
+	}
+
+	if (next_kind == REPLAY_INPUT && next_tick == tick) {
+		uint64_t inputs = 0;
+		if (!get_varint(inputs)) {
+			stop();
+			return false;
+		}
+		out.inputs = static_cast<Inputs>(inputs);
+		read_record();
+	}
+	if (next_kind == REPLAY_HASH && next_tick == tick) {
+		uint64_t hash = 0;
+		if (!get_varint(hash)) {
+			stop();
+			return false;
+		}
+		out.check = true;
+		out.hash = static_cast<uint32_t>(hash);
+		read_record();
+	}
+	++tick;
+	return true;
+}
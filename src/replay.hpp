@@ -0,0 +1,109 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "game.hpp"
+
+// A replay is the seed of a game and the inputs of every step, enough to play it
+// again exactly.
+//
+// File layout: the magic bytes "TTRP", a version byte, then the seed, the tick
+// rate, the `GravityConfig` (gravity, lock delay, lock resets) and a stream of
+// records, all as LEB128 varints. Each record starts with the
+// number of steps since the previous record, shifted left by two, and its kind in
+// the low two bits:
+//  - REPLAY_INPUT, followed by the input byte of that step. Steps without input
+//    are not written.
+//  - REPLAY_HASH, followed by `state_hash` of the state after that step, written
+//    every `REPLAY_HASH_INTERVAL` steps to catch a replay drifting from the game.
+//  - REPLAY_END, at the step after the last one played.
+const uint8_t REPLAY_VERSION = 8;
+const uint64_t REPLAY_HASH_INTERVAL = 120;
+
+enum ReplayRecord : uint8_t {
+	REPLAY_INPUT = 0,
+	REPLAY_HASH = 1,
+	REPLAY_END = 2,
+};
+
+// A 32 bit hash of everything that decides how a game goes on: the position (see
+// position.hpp), the gravity and lock delay counters and the score.
+uint32_t state_hash(const GameState &st);
+
+// Writes a replay while a game is played. Records go through a fixed buffer
+// straight to the file, so recording never allocates.
+class ReplayWriter {
+  private:
+	FILE *file = nullptr;
+	std::array<uint8_t, 4096> buf{};
+	size_t len = 0;
+	uint64_t tick = 0;		  // steps recorded so far
+	uint64_t last_record = 0; // step of the previous record
+
+	void put_varint(uint64_t value);
+	void put_record(ReplayRecord kind);
+	void flush();
+
+  public:
+	ReplayWriter() = default;
+	ReplayWriter(const ReplayWriter &) = delete;
+	ReplayWriter &operator=(const ReplayWriter &) = delete;
+	~ReplayWriter() { close(); }
+
+	// Starts a replay of a game made with `Game(seed, tick_rate, gravity)`. Returns
+	// false when `path` cannot be written.
+	bool
+	open(const char *path, uint32_t seed, int tick_rate, const GravityConfig &gravity);
+	bool is_open() const { return file != nullptr; }
+
+	// Records one step, `st` is the state after stepping with `inputs`.
+	void record(Inputs inputs, const GameState &st);
+	// Ends the replay at the current step and closes the file.
+	void close();
+};
+
+// What a replay says about one step
+struct ReplayStep {
+	Inputs inputs = INPUT_NONE;
+	bool check = false; // `hash` is the hash of the state after the step
+	uint32_t hash = 0;
+};
+
+// Reads a replay back one step at a time.
+class ReplayReader {
+  private:
+	std::vector<uint8_t> data;
+	size_t pos = 0;
+	uint32_t game_seed = 0;
+	int game_tick_rate = BASE_TICK_RATE;
+	GravityConfig game_gravity{};
+	uint64_t tick = 0;
+	// the record waiting to be reached
+	ReplayRecord next_kind = REPLAY_END;
+	uint64_t next_tick = 0;
+	bool corrupt = false;
+
+	bool get_varint(uint64_t &value);
+	void read_record();
+	void stop();
+
+  public:
+	// Reads the whole file at `path`. Returns false when it cannot be read or is
+	// not a replay of this version.
+	bool load(const char *path);
+
+	uint32_t seed() const { return game_seed; }
+	int tick_rate() const { return game_tick_rate; }
+	const GravityConfig &gravity() const { return game_gravity; }
+	// Number of steps read so far
+	uint64_t steps() const { return tick; }
+	// True when the file ended without an end record, the replay stops early.
+	bool truncated() const { return corrupt; }
+
+	// The next step. Returns false once the replay has ended.
+	bool next(ReplayStep &out);
+};
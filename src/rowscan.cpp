@@ -0,0 +1,123 @@
+#include "rowscan.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define ROWSCAN_X86 1
+#endif
+
+static void
+find_rows_equal_scalar(const uint16_t *rows, size_t count, uint16_t mask, uint64_t *out) {
+	find_rows_equal<uint16_t>(rows, count, mask, out);
+}
+
+static size_t first_nonempty_scalar(const uint16_t *rows, size_t count) {
+	return first_nonempty_row<uint16_t>(rows, count);
+}
+
+#ifdef ROWSCAN_X86
+// One 64 row word of the result at a time, the rows past the last whole word go
+// through the scalar loop.
+__attribute__((target("sse2"))) static void
+find_rows_equal_sse2(const uint16_t *rows, size_t count, uint16_t mask, uint64_t *out) {
+	const __m128i want = _mm_set1_epi16(static_cast<short>(mask));
+	size_t i = 0;
+	for (; i + 64 <= count; i += 64) {
+		uint64_t word = 0;
+		for (size_t j = 0; j < 64; j += 16) {
+			__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(rows + i + j));
+			__m128i b =
+				_mm_loadu_si128(reinterpret_cast<const __m128i *>(rows + i + j + 8));
+			// the equal lanes are all ones, packing them to bytes keeps one bit per row
+			__m128i eq =
+				_mm_packs_epi16(_mm_cmpeq_epi16(a, want), _mm_cmpeq_epi16(b, want));
+			auto bits = static_cast<uint32_t>(_mm_movemask_epi8(eq));
+			word |= static_cast<uint64_t>(bits) << j;
+		}
+		out[i / 64] = word;
+	}
+	find_rows_equal<uint16_t>(rows + i, count - i, mask, out + i / 64);
+}
+
+__attribute__((target("sse2"))) static size_t
+first_nonempty_sse2(const uint16_t *rows, size_t count) {
+	const __m128i zero = _mm_setzero_si128();
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m128i r = _mm_loadu_si128(reinterpret_cast<const __m128i *>(rows + i));
+		if (_mm_movemask_epi8(_mm_cmpeq_epi16(r, zero)) != 0xFFFF) {
+			break;
+		}
+	}
+	return i + first_nonempty_row<uint16_t>(rows + i, count - i);
+}
+
+__attribute__((target("avx2"))) static void
+find_rows_equal_avx2(const uint16_t *rows, size_t count, uint16_t mask, uint64_t *out) {
+	const __m256i want = _mm256_set1_epi16(static_cast<short>(mask));
+	size_t i = 0;
+	for (; i + 64 <= count; i += 64) {
+		uint64_t word = 0;
+		for (size_t j = 0; j < 64; j += 32) {
+			__m256i a =
+				_mm256_loadu_si256(reinterpret_cast<const __m256i *>(rows + i + j));
+			__m256i b =
+				_mm256_loadu_si256(reinterpret_cast<const __m256i *>(rows + i + j + 16));
+			__m256i eq = _mm256_packs_epi16(
+				_mm256_cmpeq_epi16(a, want), _mm256_cmpeq_epi16(b, want)
+			);
+			// packing works within each 128 bit half, put the row order back
+			eq = _mm256_permute4x64_epi64(eq, 0xD8);
+			auto bits = static_cast<uint32_t>(_mm256_movemask_epi8(eq));
+			word |= static_cast<uint64_t>(bits) << j;
+		}
+		out[i / 64] = word;
+	}
+	find_rows_equal<uint16_t>(rows + i, count - i, mask, out + i / 64);
+}
+
+__attribute__((target("avx2"))) static size_t
+first_nonempty_avx2(const uint16_t *rows, size_t count) {
+	size_t i = 0;
+	for (; i + 16 <= count; i += 16) {
+		__m256i r = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(rows + i));
+		if (!_mm256_testz_si256(r, r)) {
+			break;
+		}
+	}
+	return i + first_nonempty_row<uint16_t>(rows + i, count - i);
+}
+#endif
+
+struct RowScanKernels {
+	const char *name;
+	void (*find_equal)(const uint16_t *, size_t, uint16_t, uint64_t *);
+	size_t (*first_nonempty)(const uint16_t *, size_t);
+};
+
+static RowScanKernels pick_kernels() {
+#ifdef ROWSCAN_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) {
+		return {"avx2", find_rows_equal_avx2, first_nonempty_avx2};
+	}
+	if (__builtin_cpu_supports("sse2")) {
+		return {"sse2", find_rows_equal_sse2, first_nonempty_sse2};
+	}
+#endif
+	return {"scalar", find_rows_equal_scalar, first_nonempty_scalar};
+}
+
+static const RowScanKernels &kernels() {
+	static const RowScanKernels picked = pick_kernels();
+	return picked;
+}
+
+void find_rows_equal(const uint16_t *rows, size_t count, uint16_t mask, uint64_t *out) {
+	kernels().find_equal(rows, count, mask, out);
+}
+
+size_t first_nonempty_row(const uint16_t *rows, size_t count) {
+	return kernels().first_nonempty(rows, count);
+}
+
+const char *row_scan_kernel() { return kernels().name; }
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Scans over the row masks of a board, for boards tall enough that testing them one
+// at a time shows. The 16 bit rows of boards up to 16 wide are compared 8 (SSE2)
+// or 16 (AVX2) at a time, whichever the CPU supports, picked once at startup.
+// Other CPUs and other row types go a row at a time.
+
+// Sets bit `i % 64` of `out[i / 64]` for every `rows[i]` equal to `mask`, clears
+// the others. `out` needs `(count + 63) / 64` words.
+void find_rows_equal(const uint16_t *rows, size_t count, uint16_t mask, uint64_t *out);
+// Index of the first row that is not empty, `count` when they all are.
+size_t first_nonempty_row(const uint16_t *rows, size_t count);
+// Name of the kernels in use, "avx2", "sse2" or "scalar"
+const char *row_scan_kernel();
+
+template <class R>
+void find_rows_equal(const R *rows, size_t count, const R &mask, uint64_t *out) {
+	for (size_t w = 0; w < (count + 63) / 64; ++w) {
+		out[w] = 0;
+	}
+	for (size_t i = 0; i < count; ++i) {
+		if (rows[i] == mask) {
+			out[i / 64] |= uint64_t{1} << (i % 64);
+		}
+	}
+}
+template <class R> size_t first_nonempty_row(const R *rows, size_t count) {
+	for (size_t i = 0; i < count; ++i) {
+		if (rows[i] != R{}) {
+			return i;
+		}
+	}
+	return count;
+}
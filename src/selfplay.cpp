@@ -0,0 +1,229 @@
+// Plays seeded games headless on every core and summarises how they went, for
+// judging changes to the rules and the difficulty curve.
+//
+// usage: tetris_selfplay [-n games] [-j threads] [-s seed] [-m max_pieces]
+//                        [-p random|greedy|scripted|beam] [-S script]
+//                        [-w beam_width] [-d depth] [-b budget_us]
+//
+// Game `i` is played with seed `seed + i`, so a run is repeatable for the same
+// arguments no matter how many threads it uses. Games are stopped after
+// `max_pieces` pieces, the default policy can play for a very long time. The
+// length of a game is the time gravity alone would take to bring every piece down
+// at 60 steps a second, as the frontend runs.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "game.hpp"
+#include "movegen.hpp"
+#include "policy.hpp"
+#include "pool.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+	size_t games = 1000;
+	size_t threads = std::max(1U, std::thread::hardware_concurrency());
+	uint32_t seed = 1;
+	uint64_t max_pieces = 10000;
+	std::string policy = "greedy";
+	std::vector<ScriptedMove> script;
+	BotConfig bot;
+};
+
+struct GameResult {
+	uint score = 0;
+	uint64_t lines = 0;
+	uint64_t pieces = 0;
+	uint64_t steps = 0; // gravity steps, see the top of the file
+	uint difficulty = 0;
+	bool capped = false; // stopped at `max_pieces` instead of lost
+};
+
+static std::unique_ptr<Policy> make_policy(const Options &opt, uint32_t seed) {
+	if (opt.policy == "random") {
+		return std::make_unique<RandomPolicy>(seed);
+	}
+	if (opt.policy == "scripted") {
+		return std::make_unique<ScriptedPolicy>(opt.script);
+	}
+	if (opt.policy == "beam") {
+		return std::make_unique<BeamPolicy>(opt.bot);
+	}
+	return std::make_unique<GreedyPolicy>();
+}
+
+static GameResult play(const Options &opt, uint32_t seed, PlacementList &placements) {
+	Game game{seed};
+	auto policy = make_policy(opt, seed);
+
+	GameResult res{};
+	while (!game.state().over) {
+		if (res.pieces == opt.max_pieces) {
+			res.capped = true;
+			break;
+		}
+		if (policy->hold(game.state())) {
+			game.hold();
+		}
+		const GameState &st = game.state();
+		generate_placements(st.board, st.tet.get_type(), placements);
+		if (placements.count == 0) {
+			break; // spawned into the stack
+		}
+		const Placement &p = placements.items[policy->choose(st, placements)];
+		// falling from spawn at the gravity of the level, then the lock delay
+		auto rows = static_cast<uint64_t>(std::max(0, p.y - st.tet.get_y_offset()));
+		res.steps += ((rows * CELL) + st.gravity - 1) / st.gravity;
+		res.steps += static_cast<uint64_t>(
+			(st.config.lock_delay_ms * st.tick_rate / 1000) + 1
+		);
+
+		auto step = game.place(p);
+		res.lines += static_cast<uint64_t>(step.cleared.count);
+		++res.pieces;
+	}
+	res.score = game.state().score;
+	res.difficulty = game.state().difficulty;
+	return res;
+}
+
+template <class F>
+static void print_stats(const char *name, const std::vector<GameResult> &results, F &&get) {
+	std::vector<double> values;
+	values.reserve(results.size());
+	double total = 0;
+	for (const auto &r : results) {
+		values.push_back(static_cast<double>(get(r)));
+		total += values.back();
+	}
+	std::sort(values.begin(), values.end());
+	std::printf(
+		"%-12s mean %12.1f  min %10.0f  p50 %10.0f  p90 %10.0f  max %10.0f\n",
+		name,
+		total / static_cast<double>(values.size()),
+		values.front(),
+		values[values.size() / 2],
+		values[values.size() * 9 / 10],
+		values.back()
+	);
+}
+
+static bool parse_options(int argc, char **argv, Options &opt) {
+	for (int i = 1; i < argc; ++i) {
+		if (i + 1 >= argc || argv[i][0] != '-' || std::strlen(argv[i]) != 2) {
+			return false;
+		}
+		const char *value = argv[++i];
+		switch (argv[i - 1][1]) {
+		case 'n':
+			opt.games = std::strtoull(value, nullptr, 10);
+			break;
+		case 'j':
+			opt.threads = std::strtoull(value, nullptr, 10);
+			break;
+		case 's':
+			opt.seed = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+			break;
+		case 'm':
+			opt.max_pieces = std::strtoull(value, nullptr, 10);
+			break;
+		case 'p':
+			opt.policy = value;
+			break;
+		case 'S':
+			if (!parse_script(value, opt.script)) {
+				std::fprintf(stderr, "script must look like 0:3,1:-1,2:4\n");
+				return false;
+			}
+			break;
+		case 'w':
+			opt.bot.beam_width = std::strtoull(value, nullptr, 10);
+			break;
+		case 'd':
+			opt.bot.depth = std::atoi(value);
+			break;
+		case 'b':
+			opt.bot.budget = std::chrono::microseconds(std::strtoll(value, nullptr, 10));
+			break;
+		default:
+			return false;
+		}
+	}
+	if (opt.policy != "random" && opt.policy != "greedy" && opt.policy != "scripted" &&
+		opt.policy != "beam") {
+		return false;
+	}
+	if (opt.policy == "scripted" && opt.script.empty()) {
+		std::fprintf(stderr, "the scripted policy needs a script, -S\n");
+		return false;
+	}
+	return opt.games > 0 && opt.threads > 0;
+}
+
+int main(int argc, char **argv) {
+	Options opt{};
+	if (!parse_options(argc, argv, opt)) {
+		std::fprintf(
+			stderr,
+			"usage: %s [-n games] [-j threads] [-s seed] [-m max_pieces] "
+			"[-p random|greedy|scripted|beam] [-S script] [-w beam_width] [-d depth] "
+			"[-b budget_us]\n",
+			argv[0]
+		);
+		return 1;
+	}
+	opt.threads = std::min(opt.threads, opt.games);
+
+	std::vector<GameResult> results(opt.games);
+	// placement lists are large, one per thread
+	std::vector<PlacementList> lists(opt.threads);
+
+	auto start = Clock::now();
+	run_parallel(opt.games, opt.threads, [&](size_t game, size_t worker) {
+		results[game] = play(opt, opt.seed + static_cast<uint32_t>(game), lists[worker]);
+	});
+	double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+	uint64_t pieces = 0;
+	uint64_t lines = 0;
+	size_t capped = 0;
+	for (const auto &r : results) {
+		pieces += r.pieces;
+		lines += r.lines;
+		capped += r.capped ? 1 : 0;
+	}
+
+	std::printf(
+		"%zu games, policy %s, seed %u, %zu threads, %zu stopped at %llu pieces\n",
+		opt.games,
+		opt.policy.c_str(),
+		opt.seed,
+		opt.threads,
+		capped,
+		static_cast<unsigned long long>(opt.max_pieces)
+	);
+	print_stats("score", results, [](const GameResult &r) { return r.score; });
+	print_stats("lines", results, [](const GameResult &r) { return r.lines; });
+	print_stats("pieces", results, [](const GameResult &r) { return r.pieces; });
+	print_stats("length (s)", results, [](const GameResult &r) {
+		return static_cast<double>(r.steps) / 60.0;
+	});
+	print_stats("difficulty", results, [](const GameResult &r) { return r.difficulty; });
+	std::printf(
+		"total        %llu pieces, %llu lines in %.3fs (%.0f pieces/s)\n",
+		static_cast<unsigned long long>(pieces),
+		static_cast<unsigned long long>(lines),
+		seconds,
+		static_cast<double>(pieces) / seconds
+	);
+	return 0;
+}
@@ -0,0 +1,611 @@
+// Runs many games at once for players connecting over a socket.
+//
+// usage: tetris_server [-p port | -u socket] [-j threads] [-g games] [-r rate]
+//
+// Listens on 127.0.0.1:`port` (7878) or on the Unix socket `socket`, see
+// protocol.hpp for the messages. Up to `games` games (16384) are kept in one
+// array, split into a contiguous shard per worker thread (one per core). Each
+// worker steps the games of its shard `rate` times a second (60) on its own clock
+// and hands the diffs of the step to the network thread, which does all socket
+// reads and writes, so a slow client never holds up a step. Once a second the
+// server prints how long the steps took.
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <poll.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "game.hpp"
+#include "net.hpp"
+#include "protocol.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+// Behind by more than this, a worker drops the missed steps instead of running
+// them back to back
+const auto MAX_CATCH_UP = std::chrono::milliseconds(250);
+const size_t MAX_CONNECTIONS = 1024;
+// A client that stops reading is dropped once this much is queued for it
+const size_t MAX_OUTBOX = 4 << 20;
+// Step times are counted in buckets of `BUCKET_US`, the last one takes the rest
+const size_t LATENCY_BUCKETS = 2048;
+const int BUCKET_US = 10;
+
+static volatile std::sig_atomic_t stop_requested = 0;
+
+static void request_stop(int /*sig*/) { stop_requested = 1; }
+
+struct Options {
+	Endpoint endpoint{};
+	size_t threads = std::max(1U, std::thread::hardware_concurrency());
+	size_t games = 16384;
+	int tick_rate = BASE_TICK_RATE;
+};
+
+// The connection a game belongs to. Connection slots are reused, the generation
+// tells the connections of a slot apart.
+struct Owner {
+	uint32_t slot = 0;
+	uint32_t generation = 0;
+};
+
+struct Connection {
+	int fd = -1;
+	uint32_t generation = 0; // written by the network thread with `mutex` held
+	// network thread only
+	FrameReader in;
+	std::vector<uint8_t> sending; // taken from `outbox`, being written to the socket
+	size_t sent = 0;
+	std::vector<uint32_t> games;
+
+	std::mutex mutex;
+	std::vector<uint8_t> outbox; // diffs and replies not yet taken by `sending`
+	bool overflowed = false;
+};
+
+// One game and what its player was last told about it, only touched by the
+// worker of its shard.
+struct GameSlot {
+	Game game{0};
+	GameView view{};
+	Owner owner{};
+	uint32_t step = 0;
+	bool active = false;
+};
+
+// Joins and leaves for a worker, applied before its next step so a game is never
+// changed by two threads.
+struct Command {
+	uint32_t game;
+	uint32_t seed;
+	Owner owner;
+	bool join;
+};
+
+struct Shard {
+	uint32_t begin = 0;
+	uint32_t end = 0;
+	std::thread thread;
+
+	std::mutex mutex;
+	std::vector<Command> commands;
+
+	// how long steps took since the last report, read and reset by the reporter
+	std::array<std::atomic<uint32_t>, LATENCY_BUCKETS> step_time{};
+	std::atomic<uint32_t> overruns{0}; // steps that took longer than a tick
+	std::atomic<uint32_t> active{0};
+};
+
+class GameServer {
+  private:
+	Options opt;
+	std::vector<GameSlot> slots;
+	// inputs arrived since the last step of each game, combined
+	std::unique_ptr<std::atomic<Inputs>[]> pending;
+	std::vector<Shard> shards;
+	std::vector<Connection> conns;
+	uint32_t shard_size = 0;
+	std::atomic<bool> running{true};
+	int wake_read = -1; // a worker writes a byte to `wake_write` after a step
+	int wake_write = -1;
+
+	// network thread only
+	std::vector<uint32_t> free_games; // popped from the back
+	std::vector<int32_t> game_conn;	  // connection slot of each game, -1 when free
+	uint64_t bytes_out = 0;
+
+	void work(Shard &shard);
+	void deliver(
+		std::vector<std::vector<uint8_t>> &out, const std::vector<uint32_t> &generation,
+		std::vector<uint32_t> &touched
+	);
+
+	void accept_all(int listen_fd);
+	void receive(uint32_t slot);
+	void handle(uint32_t slot, const uint8_t *body, size_t len);
+	void flush(uint32_t slot);
+	void close_connection(uint32_t slot);
+	void leave(uint32_t game);
+	void command(const Command &cmd);
+	void report(double seconds);
+
+  public:
+	explicit GameServer(const Options &options);
+	~GameServer();
+	GameServer(const GameServer &) = delete;
+	GameServer &operator=(const GameServer &) = delete;
+
+	// Serves clients on `listen_fd` until SIGINT or SIGTERM.
+	void serve(int listen_fd);
+};
+
+GameServer::GameServer(const Options &options)
+	: opt{options}, slots(options.games), pending{new std::atomic<Inputs>[options.games]},
+	  shards(options.threads), conns(MAX_CONNECTIONS), game_conn(options.games, -1) {
+	auto count = static_cast<uint32_t>(opt.games);
+	auto threads = static_cast<uint32_t>(opt.threads);
+	shard_size = (count + threads - 1) / threads;
+	for (uint32_t i = 0; i < threads; ++i) {
+		shards[i].begin = std::min(count, i * shard_size);
+		shards[i].end = std::min(count, (i + 1) * shard_size);
+	}
+	for (uint32_t g = 0; g < count; ++g) {
+		pending[g].store(INPUT_NONE, std::memory_order_relaxed);
+	}
+	// joins go round the shards, so a part full server keeps every worker busy
+	for (uint32_t i = shard_size; i-- > 0;) {
+		for (uint32_t s = threads; s-- > 0;) {
+			uint32_t g = s * shard_size + i;
+			if (g < count) {
+				free_games.push_back(g);
+			}
+		}
+	}
+
+	int fds[2];
+	if (pipe(fds) == 0) {
+		wake_read = fds[0];
+		wake_write = fds[1];
+		set_nonblocking(wake_read);
+		set_nonblocking(wake_write);
+	}
+	for (auto &shard : shards) {
+		shard.thread = std::thread(&GameServer::work, this, std::ref(shard));
+	}
+}
+
+GameServer::~GameServer() {
+	running.store(false, std::memory_order_release);
+	for (auto &shard : shards) {
+		shard.thread.join();
+	}
+	for (auto &c : conns) {
+		if (c.fd >= 0) {
+			close(c.fd);
+		}
+	}
+	close(wake_read);
+	close(wake_write);
+}
+
+void GameServer::work(Shard &shard) {
+	const auto period = std::chrono::duration_cast<Clock::duration>(
+		std::chrono::duration<double>(1.0 / opt.tick_rate)
+	);
+	std::vector<Command> commands;
+	// this step's diffs for each connection slot, and the slots that got any
+	std::vector<std::vector<uint8_t>> out(MAX_CONNECTIONS);
+	std::vector<uint32_t> generation(MAX_CONNECTIONS);
+	std::vector<uint32_t> touched;
+	uint32_t active = 0;
+
+	auto next = Clock::now();
+	while (running.load(std::memory_order_acquire)) {
+		auto start = Clock::now();
+		{
+			std::lock_guard lock{shard.mutex};
+			std::swap(commands, shard.commands);
+		}
+		for (const auto &cmd : commands) {
+			GameSlot &s = slots[cmd.game];
+			if (cmd.join) {
+				s.game = Game{cmd.seed, opt.tick_rate};
+				s.view = GameView{};
+				s.owner = cmd.owner;
+				s.step = 0;
+				active += s.active ? 0 : 1;
+				s.active = true;
+			} else if (s.active) {
+				s.active = false;
+				--active;
+			}
+			pending[cmd.game].store(INPUT_NONE, std::memory_order_relaxed);
+		}
+		commands.clear();
+		shard.active.store(active, std::memory_order_relaxed);
+
+		for (uint32_t g = shard.begin; g < shard.end; ++g) {
+			GameSlot &s = slots[g];
+			if (!s.active || s.game.state().over) {
+				continue;
+			}
+			Inputs inputs = pending[g].exchange(INPUT_NONE, std::memory_order_relaxed);
+			s.game.step(inputs);
+			++s.step;
+
+			std::vector<uint8_t> &diffs = out[s.owner.slot];
+			bool first = diffs.empty();
+			if (write_diff(diffs, g, s.step, s.view, s.game.state()) && first) {
+				generation[s.owner.slot] = s.owner.generation;
+				touched.push_back(s.owner.slot);
+			}
+		}
+		deliver(out, generation, touched);
+
+		auto took = Clock::now() - start;
+		auto us = std::chrono::duration_cast<std::chrono::microseconds>(took).count();
+		auto bucket = std::min(LATENCY_BUCKETS - 1, static_cast<size_t>(us / BUCKET_US));
+		shard.step_time[bucket].fetch_add(1, std::memory_order_relaxed);
+		if (took > period) {
+			shard.overruns.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		next += period;
+		auto now = Clock::now();
+		if (now - next > MAX_CATCH_UP) {
+			next = now;
+		}
+		std::this_thread::sleep_until(next);
+	}
+}
+
+void GameServer::deliver(
+	std::vector<std::vector<uint8_t>> &out, const std::vector<uint32_t> &generation,
+	std::vector<uint32_t> &touched
+) {
+	if (touched.empty()) {
+		return;
+	}
+	for (uint32_t slot : touched) {
+		Connection &c = conns[slot];
+		{
+			std::lock_guard lock{c.mutex};
+			// the player may have gone since the step started
+			if (c.generation == generation[slot]) {
+				if (c.outbox.size() + out[slot].size() > MAX_OUTBOX) {
+					c.overflowed = true;
+				} else {
+					c.outbox.insert(c.outbox.end(), out[slot].begin(), out[slot].end());
+				}
+			}
+		}
+		out[slot].clear();
+	}
+	touched.clear();
+	uint8_t byte = 1;
+	// a full pipe already has the network thread awake
+	[[maybe_unused]] auto res = write(wake_write, &byte, 1);
+}
+
+void GameServer::serve(int listen_fd) {
+	std::vector<pollfd> fds;
+	std::vector<uint32_t> fd_slot;
+	auto last_report = Clock::now();
+
+	while (stop_requested == 0) {
+		fds.clear();
+		fd_slot.clear();
+		fds.push_back({.fd = listen_fd, .events = POLLIN, .revents = 0});
+		fds.push_back({.fd = wake_read, .events = POLLIN, .revents = 0});
+		for (uint32_t slot = 0; slot < conns.size(); ++slot) {
+			const Connection &c = conns[slot];
+			if (c.fd < 0) {
+				continue;
+			}
+			short events = POLLIN;
+			if (c.sent < c.sending.size()) {
+				events |= POLLOUT;
+			}
+			fds.push_back({.fd = c.fd, .events = events, .revents = 0});
+			fd_slot.push_back(slot);
+		}
+
+		if (poll(fds.data(), fds.size(), 100) < 0 && errno != EINTR) {
+			std::perror("poll");
+			return;
+		}
+		if (fds[0].revents & POLLIN) {
+			accept_all(listen_fd);
+		}
+		if (fds[1].revents & POLLIN) {
+			std::array<uint8_t, 256> drain{};
+			while (read(wake_read, drain.data(), drain.size()) > 0) {
+			}
+		}
+		for (size_t i = 2; i < fds.size(); ++i) {
+			if (fds[i].revents & (POLLIN | POLLHUP | POLLERR)) {
+				receive(fd_slot[i - 2]);
+			}
+		}
+		for (uint32_t slot = 0; slot < conns.size(); ++slot) {
+			if (conns[slot].fd >= 0) {
+				flush(slot);
+			}
+		}
+
+		auto now = Clock::now();
+		if (now - last_report >= std::chrono::seconds(1)) {
+			report(std::chrono::duration<double>(now - last_report).count());
+			last_report = now;
+		}
+	}
+}
+
+void GameServer::accept_all(int listen_fd) {
+	for (;;) {
+		int fd = accept(listen_fd, nullptr, nullptr);
+		if (fd < 0) {
+			return;
+		}
+		auto free = std::find_if(conns.begin(), conns.end(), [](const Connection &c) {
+			return c.fd < 0;
+		});
+		if (free == conns.end() || !set_nonblocking(fd)) {
+			close(fd);
+			continue;
+		}
+		set_nodelay(fd);
+		free->fd = fd;
+	}
+}
+
+void GameServer::receive(uint32_t slot) {
+	Connection &c = conns[slot];
+	const size_t chunk = 16384;
+	for (;;) {
+		ssize_t n = recv(c.fd, c.in.reserve(chunk), chunk, 0);
+		if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+			close_connection(slot);
+			return;
+		}
+		if (n < 0) {
+			break;
+		}
+		c.in.received(static_cast<size_t>(n));
+		const uint8_t *body = nullptr;
+		size_t len = 0;
+		while (c.in.next(body, len)) {
+			handle(slot, body, len);
+		}
+		if (c.in.broken()) {
+			close_connection(slot);
+			return;
+		}
+	}
+}
+
+void GameServer::handle(uint32_t slot, const uint8_t *body, size_t len) {
+	Connection &c = conns[slot];
+	uint32_t game = 0;
+	uint32_t seed = 0;
+	Inputs inputs = INPUT_NONE;
+	if (read_input(body, len, game, inputs)) {
+		if (game < opt.games && game_conn[game] == static_cast<int32_t>(slot)) {
+			pending[game].fetch_or(inputs, std::memory_order_relaxed);
+		}
+	} else if (read_join(body, len, seed)) {
+		game = NO_GAME;
+		if (!free_games.empty()) {
+			game = free_games.back();
+			free_games.pop_back();
+		}
+		{
+			// queued before the worker can get to the game, so no diff overtakes it
+			std::lock_guard lock{c.mutex};
+			write_joined(c.outbox, game);
+		}
+		if (game != NO_GAME) {
+			game_conn[game] = static_cast<int32_t>(slot);
+			c.games.push_back(game);
+			Owner owner{.slot = slot, .generation = c.generation};
+			command({.game = game, .seed = seed, .owner = owner, .join = true});
+		}
+	} else if (read_leave(body, len, game)) {
+		if (game < opt.games && game_conn[game] == static_cast<int32_t>(slot)) {
+			c.games.erase(std::find(c.games.begin(), c.games.end(), game));
+			leave(game);
+		}
+	}
+}
+
+void GameServer::flush(uint32_t slot) {
+	Connection &c = conns[slot];
+	if (c.sent == c.sending.size()) {
+		c.sending.clear();
+		c.sent = 0;
+		bool overflowed = false;
+		{
+			std::lock_guard lock{c.mutex};
+			std::swap(c.sending, c.outbox);
+			overflowed = c.overflowed;
+		}
+		if (overflowed) {
+			close_connection(slot);
+			return;
+		}
+	}
+	while (c.sent < c.sending.size()) {
+		ssize_t n = send(c.fd, c.sending.data() + c.sent, c.sending.size() - c.sent, 0);
+		if (n < 0) {
+			if (errno != EAGAIN && errno != EWOULDBLOCK) {
+				close_connection(slot);
+			}
+			return;
+		}
+		c.sent += static_cast<size_t>(n);
+		bytes_out += static_cast<uint64_t>(n);
+	}
+}
+
+void GameServer::close_connection(uint32_t slot) {
+	Connection &c = conns[slot];
+	for (uint32_t game : c.games) {
+		leave(game);
+	}
+	c.games.clear();
+	{
+		std::lock_guard lock{c.mutex};
+		++c.generation;
+		c.outbox.clear();
+		c.overflowed = false;
+	}
+	close(c.fd);
+	c.fd = -1;
+	c.in = FrameReader{};
+	c.sending.clear();
+	c.sent = 0;
+}
+
+void GameServer::leave(uint32_t game) {
+	game_conn[game] = -1;
+	// the leave is queued before any later join of the same game, same shard
+	free_games.push_back(game);
+	command({.game = game, .seed = 0, .owner = {}, .join = false});
+}
+
+void GameServer::command(const Command &cmd) {
+	Shard &shard = shards[cmd.game / shard_size];
+	std::lock_guard lock{shard.mutex};
+	shard.commands.push_back(cmd);
+}
+
+void GameServer::report(double seconds) {
+	std::array<uint64_t, LATENCY_BUCKETS> counts{};
+	uint64_t steps = 0;
+	uint64_t overruns = 0;
+	uint64_t active = 0;
+	for (auto &shard : shards) {
+		for (size_t b = 0; b < LATENCY_BUCKETS; ++b) {
+			uint32_t n = shard.step_time[b].exchange(0, std::memory_order_relaxed);
+			counts[b] += n;
+			steps += n;
+		}
+		overruns += shard.overruns.exchange(0, std::memory_order_relaxed);
+		active += shard.active.load(std::memory_order_relaxed);
+	}
+	if (steps == 0) {
+		return;
+	}
+
+	// upper bound of the bucket the `q` quantile falls in
+	auto quantile = [&](double q) {
+		auto want = static_cast<uint64_t>(q * static_cast<double>(steps));
+		want = std::min(want, steps - 1);
+		uint64_t seen = 0;
+		for (size_t b = 0; b < LATENCY_BUCKETS; ++b) {
+			seen += counts[b];
+			if (seen > want) {
+				return static_cast<int>(b + 1) * BUCKET_US;
+			}
+		}
+		return static_cast<int>(LATENCY_BUCKETS) * BUCKET_US;
+	};
+	std::printf(
+		"%llu games, %.0f shard steps/s, step p50 %dus p99 %dus max %dus, %llu over "
+		"a tick, %.2f MB/s out\n",
+		static_cast<unsigned long long>(active),
+		static_cast<double>(steps) / seconds,
+		quantile(0.5),
+		quantile(0.99),
+		quantile(1.0),
+		static_cast<unsigned long long>(overruns),
+		static_cast<double>(bytes_out) / seconds / 1e6
+	);
+	std::fflush(stdout);
+	bytes_out = 0;
+}
+
+static bool parse_options(int argc, char **argv, Options &opt) {
+	for (int i = 1; i < argc; ++i) {
+		if (i + 1 >= argc || argv[i][0] != '-' || std::strlen(argv[i]) != 2) {
+			return false;
+		}
+		const char *value = argv[++i];
+		switch (argv[i - 1][1]) {
+		case 'p':
+			opt.endpoint.port = static_cast<uint16_t>(std::strtoul(value, nullptr, 10));
+			break;
+		case 'u':
+			opt.endpoint.unix_path = value;
+			break;
+		case 'j':
+			opt.threads = std::strtoull(value, nullptr, 10);
+			break;
+		case 'g':
+			opt.games = std::strtoull(value, nullptr, 10);
+			break;
+		case 'r':
+			opt.tick_rate = std::atoi(value);
+			break;
+		default:
+			return false;
+		}
+	}
+	return opt.threads > 0 && opt.games > 0 && opt.games < NO_GAME &&
+		   opt.tick_rate >= 1 && opt.tick_rate <= 10000;
+}
+
+int main(int argc, char **argv) {
+	Options opt{};
+	if (!parse_options(argc, argv, opt)) {
+		std::fprintf(
+			stderr,
+			"usage: %s [-p port | -u socket] [-j threads] [-g games] [-r rate]\n",
+			argv[0]
+		);
+		return 1;
+	}
+	opt.threads = std::min(opt.threads, opt.games);
+
+	int listen_fd = listen_on(opt.endpoint);
+	if (listen_fd < 0) {
+		std::perror("listen");
+		return 1;
+	}
+	std::signal(SIGPIPE, SIG_IGN);
+	std::signal(SIGINT, request_stop);
+	std::signal(SIGTERM, request_stop);
+
+	std::printf(
+		"serving up to %zu games on %s%s, %zu threads at %d steps/s\n",
+		opt.games,
+		opt.endpoint.unix_path.empty() ? "127.0.0.1:" : "",
+		opt.endpoint.unix_path.empty() ? std::to_string(opt.endpoint.port).c_str()
+									   : opt.endpoint.unix_path.c_str(),
+		opt.threads,
+		opt.tick_rate
+	);
+	std::fflush(stdout);
+	{
+		GameServer server{opt};
+		server.serve(listen_fd);
+	}
+	close(listen_fd);
+	if (!opt.endpoint.unix_path.empty()) {
+		unlink(opt.endpoint.unix_path.c_str());
+	}
+	return 0;
+}
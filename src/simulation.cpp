@@ -0,0 +1,86 @@
+#include <chrono>
+
+#include "profiler.hpp"
+#include "simulation.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+// Behind by more than this (a debugger break, a suspended machine), the missed
+// ticks are dropped instead of run back to back
+const auto MAX_CATCH_UP = std::chrono::milliseconds(250);
+// How often a paused simulation looks whether it was resumed
+const auto PAUSE_POLL = std::chrono::milliseconds(10);
+
+Simulation::Simulation(
+	uint32_t seed, int tick_rate, const GravityConfig &gravity,
+	const HandlingConfig &handling, SimulationHooks &tick_hooks
+)
+	: game{seed, tick_rate, gravity}, hooks{tick_hooks}, handler{handling} {
+	publish(false);
+}
+
+void Simulation::start() {
+	if (running.exchange(true)) {
+		return;
+	}
+	thread = std::thread(&Simulation::run, this);
+}
+
+void Simulation::stop() {
+	running.store(false, std::memory_order_release);
+	if (thread.joinable()) {
+		thread.join();
+	}
+}
+
+void Simulation::publish(bool finished) {
+	Snapshot &snap = snapshots.write_slot();
+	snap.state = game.state();
+	{
+		ProfileScope scope{PHASE_GHOST};
+		snap.ghost = game.ghost();
+	}
+	snap.tick = tick;
+	snap.finished = finished;
+	snapshots.publish();
+}
+
+void Simulation::run() {
+	const auto period = std::chrono::duration_cast<Clock::duration>(
+		std::chrono::duration<double>(1.0 / game.state().tick_rate)
+	);
+	auto next = Clock::now();
+	while (running.load(std::memory_order_acquire)) {
+		if (paused.load(std::memory_order_acquire)) {
+			std::this_thread::sleep_for(PAUSE_POLL);
+			next = Clock::now();
+			continue;
+		}
+		InputEvent ev{};
+		while (events.pop(ev)) {
+			handler.event(ev);
+		}
+		Inputs inputs = INPUT_NONE;
+		if (!hooks.next_inputs(handler.step(input_now()), inputs)) {
+			publish(true);
+			return;
+		}
+		StepResult res{};
+		if (!hooks.autoplay(game, res)) {
+			res = game.step(inputs);
+		}
+		++tick;
+		hooks.stepped(inputs, res, game.state());
+		publish(res.over);
+		if (res.over) {
+			return;
+		}
+
+		next += period;
+		auto now = Clock::now();
+		if (now - next > MAX_CATCH_UP) {
+			next = now;
+		}
+		std::this_thread::sleep_until(next);
+	}
+}
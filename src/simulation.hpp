@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+#include "game.hpp"
+#include "input.hpp"
+#include "tet.hpp"
+#include "triple_buffer.hpp"
+
+// What the renderer needs of the game after a tick
+struct Snapshot {
+	GameState state{0};
+	Tetramino ghost{PIECE_I};
+	uint64_t tick = 0;
+	// the game is over or its inputs ran out, no further snapshots follow
+	bool finished = false;
+};
+
+// Where a simulation gets its inputs and reports its ticks. All are called on the
+// simulation thread.
+class SimulationHooks {
+  public:
+	virtual ~SimulationHooks() = default;
+
+	// The inputs of the next tick, `pressed` is what the input handler made of the
+	// button events so far. Returning false ends the game.
+	virtual bool next_inputs(Inputs pressed, Inputs &out) {
+		out = pressed;
+		return true;
+	}
+	// Lets a bot play the tick on `game` itself, through `Game::place` and
+	// `Game::hold`. Returning false steps the game with the inputs as usual.
+	virtual bool autoplay(Game & /*game*/, StepResult & /*res*/) { return false; }
+	// Called after every tick with the inputs it ran with.
+	virtual void
+	stepped(Inputs /*inputs*/, const StepResult & /*res*/, const GameState & /*st*/) {}
+};
+
+// Runs a game on its own thread at a fixed tick rate, so gravity and lock timing
+// follow the clock no matter how long frames take to draw. The renderer pushes
+// button events with `push` and draws `latest`, neither ever blocks.
+class Simulation {
+  private:
+	Game game;
+	SimulationHooks &hooks;
+	TripleBuffer<Snapshot> snapshots{Snapshot{}};
+	InputQueue events;
+	InputHandler handler;
+	std::atomic<bool> running{false};
+	std::atomic<bool> paused{false};
+	std::thread thread;
+	uint64_t tick = 0;
+
+	void run();
+	void publish(bool finished);
+
+  public:
+	Simulation(
+		uint32_t seed, int tick_rate, const GravityConfig &gravity,
+		const HandlingConfig &handling, SimulationHooks &tick_hooks
+	);
+	~Simulation() { stop(); }
+	Simulation(const Simulation &) = delete;
+	Simulation &operator=(const Simulation &) = delete;
+
+	void start();
+	// Stops the thread after its current tick.
+	void stop();
+	// Holds the game between ticks, no time passes for it until it is resumed.
+	void set_paused(bool pause) { paused.store(pause, std::memory_order_release); }
+	bool is_paused() const { return paused.load(std::memory_order_acquire); }
+
+	// Queues a button event for the next tick, only for one producer thread.
+	// Returns false when the queue is full and `ev` was dropped.
+	bool push(const InputEvent &ev) { return events.push(ev); }
+	// The state after the newest tick, only for one reader thread. Stays valid
+	// until the next call.
+	const Snapshot &latest() { return snapshots.read(); }
+};
@@ -1,71 +1,62 @@
 #pragma once
 
+#include <array>
+#include <cstddef>
 #include <cstdint>
-#include <raylib.h>
 
 #include "block.hpp"
+#include "pieces.hpp"
 
-using std::array, std::vector;
+template <int W, int H> class BasicBoard;
 
-struct RotationOffsets {
-	// clang-format off
-	array<Coordinate,5> ZERO =  {{{0, 0}, {0, 0},  {0, 0},   {0, 0},  {0, 0}}};
-	array<Coordinate,5> RIGHT = {{{0, 0}, {1, 0},  {1, -1},  {0, 2},  {1, 2}}};
-	array<Coordinate,5> TWO =   {{{0, 0}, {0, 0},  {0, 0},   {0, 0},  {0, 0}}};
-	array<Coordinate,5> LEFT =  {{{0, 0}, {-1, 0}, {-1, -1}, {0, 2},  {-1, 2}}};
-	// clang-format on
-	array<Coordinate, 5> get_rotation_offset(size_t i) {
-		switch (i) {
-		case 0:
-			return ZERO;
-		case 1:
-			return LEFT;
-		case 2:
-			return TWO;
-		case 3:
-			return RIGHT;
-		};
-		return ZERO;
-	}
-};
-
-typedef array<array<bool, 5>, 5> Pattern;
+using std::array;
 
-// Tetramino constants use relative block coordinates
+// A live piece, as its type, orientation and pattern offset. Shapes and kicks are
+// looked up in `PIECES`, so a piece is a few bytes and copies for free.
 class Tetramino {
   private:
-	array<Pattern, 4> pattern;
-	int x_offset = 3;
-	int y_offset = -3;
-	size_t pattern_idx = 0;
-	RotationOffsets rotation_offsets{};
-	size_t rotate_internal(
-		vector<Block> board, array<Coordinate, 5> o1, array<Coordinate, 5> o2,
-		size_t new_idx
-	);
+	PieceType type;
+	uint8_t pattern_idx = 0;
+	int16_t x_offset = SPAWN_X;
+	int16_t y_offset = SPAWN_Y;
+	template <int W, int H>
+	size_t
+	rotate_internal(const BasicBoard<W, H> &board, const Kicks &kicks, size_t new_idx);
 
   public:
-	array<Block, 4> blocks;
-	// `pattern` should only contain 4 ones, will otherwise return early, and log
-	// error.
-	array<Block, 4> create_blocks(Pattern pattern, Color color);
+	// The blocks of the piece on the board, built from its cells in `PIECES`
+	array<Block, 4> blocks() const {
+		const PieceDef &def = PIECES[type];
+		array<Block, 4> out{};
+		for (size_t i = 0; i < 4; ++i) {
+			Coordinate cell = def.cells[pattern_idx][i];
+			out[i] = Block{
+				.pos = {.x = cell.x + x_offset, .y = cell.y + y_offset},
+				.color = def.color,
+			};
+		}
+		return out;
+	}
 
-	void move(int y, int x);
+	void move(int x, int y);
 
-	void fall();
-	void left();
-	void right();
-	size_t rotate_cw(vector<Block> board);
-	size_t rotate_ccw(vector<Block> board);
+	void fall() { move(0, 1); }
+	void left() { move(-1, 0); }
+	void right() { move(1, 0); }
+	template <int W, int H> size_t rotate_cw(const BasicBoard<W, H> &board);
+	template <int W, int H> size_t rotate_ccw(const BasicBoard<W, H> &board);
 
-	array<Pattern, 4> get_pattern() { return pattern; }
-	void set_pattern(array<Pattern, 4> ptn, Color clr);
+	PieceType get_type() const { return type; }
+	// Swaps in the shape of `piece`, keeping the position and orientation.
+	void set_type(PieceType piece) { type = piece; }
 
-	int get_x_offset() { return x_offset; }
-	int get_y_offset() { return y_offset; }
+	int get_x_offset() const { return x_offset; }
+	int get_y_offset() const { return y_offset; }
+	size_t get_pattern_idx() const { return pattern_idx; }
 
-	Tetramino(Color color, array<Pattern, 4> pattern);
-	Tetramino(Color color, array<Pattern, 4> pattern, RotationOffsets rotation_offsets);
+	explicit Tetramino(PieceType piece) : type{piece} {}
+	// A piece in orientation `idx` with its pattern at offset (`x`, `y`)
+	Tetramino(PieceType piece, size_t idx, int x, int y);
 };
 
 Tetramino create_i_tet();
@@ -75,6 +66,3 @@ Tetramino create_l_tet();
 Tetramino create_o_tet();
 Tetramino create_s_tet();
 Tetramino create_z_tet();
-Tetramino create_random_tet();
-
-void draw_next_tet();
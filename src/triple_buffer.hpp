@@ -0,0 +1,41 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// Hands values from one writer thread to one reader thread without locks. The
+// writer fills the back slot and swaps it with the middle one, the reader swaps
+// the middle one with its front slot when it holds something newer. Neither side
+// ever waits for the other, the reader always gets the newest complete value and
+// skips any it was too slow to see.
+template <class T> class TripleBuffer {
+  private:
+	// set on `middle` when it holds a value the reader has not taken yet
+	static constexpr uint8_t FRESH = 4;
+
+	std::array<T, 3> slots;
+	alignas(64) std::atomic<uint8_t> middle{1};
+	alignas(64) uint8_t back = 0; // writer only
+	alignas(64) uint8_t front = 2; // reader only
+
+  public:
+	explicit TripleBuffer(const T &init) : slots{init, init, init} {}
+
+	// The slot to fill before `publish`, only for the writer.
+	T &write_slot() { return slots[back]; }
+	void publish() {
+		uint8_t old = middle.exchange(back | FRESH, std::memory_order_acq_rel);
+		back = old & 3;
+	}
+
+	// The newest published value, only for the reader. Stays valid and unchanged
+	// until the next call.
+	const T &read() {
+		if (middle.load(std::memory_order_relaxed) & FRESH) {
+			uint8_t old = middle.exchange(front, std::memory_order_acq_rel);
+			front = old & 3;
+		}
+		return slots[front];
+	}
+};